@@ -15,167 +15,1128 @@
 // ============================================================================
 
 // Inclusão das bibliotecas padrão necessárias para entrada/saída, alocação de memória, manipulação de strings e tempo.
+// As funções POSIX (mmap, ftruncate, fileno...) ficam visíveis também com -std=c11.
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <math.h>
 #include <string.h>
+#include <limits.h>
 #include <time.h>
 #include <locale.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#if defined(__GLIBC__)
+#include <execinfo.h>
+#endif
 
 // --- Constantes Globais ---
 // Definem valores fixos para o número de territórios, missões e tamanho máximo de strings, facilitando a manutenção.
 #define TOTAL_TERRITORIOS 5
+#define TOTAL_CONTINENTES 3
+#define TOTAL_JOGADORES 5
+#define TOTAL_FRONTEIRAS 7
+#define MAX_JOGADORES 255     // IDs de jogador vão de 0 a MAX_JOGADORES - 1
+#define MAX_CONTINENTES 64    // posse de continentes cabe em uma máscara de 64 bits
+#define MAX_MISSOES (MAX_JOGADORES + 3 + MAX_CONTINENTES) // maior catálogo que montarCatalogo() pode gerar
+#define TROPAS_OCUPACAO 2     // tropas mínimas para um território contar como "ocupado" nas missões
 #define TAM_NOME 50
 #define TAM_COR 20
 #define MISS_DESC_TAM 128
+#define TAM_LINHA 256         // maior linha de comando lida do terminal
+#define MAX_TOKENS 8          // palavras (ou nomes entre aspas) por comando
+#define OPCAO_COMANDO (-2)    // "opção" do menu quando a linha digitada era um comando por nome
+#define FIM_ENTRADA (-2)      // retorno de lerInteiro()/lerTerritorio() quando a entrada acabou
+#define COLUNA_AMEACA 1u      // coluna opcional de exibirMapa(): chance de conquista no próximo turno
+#define MAX_DADOS 3
+#define MAX_TROPAS_BLITZ 64   // maior pilha de tropas com probabilidade de blitz tabelada exatamente
+#define REFORCO_MINIMO 3
+#define LIMIAR_ATAQUE_AUTOMATICO 0.6 // chance mínima de conquista para um exército automático atacar
+#define ATAQUES_POR_TURNO 32         // ataques (blitz) de um exército automático por turno, no máximo
+#define RODADAS_SIMULACAO 500        // rodadas por partida simulada antes de declarar empate
+#define MAX_PASSOS_PLANO 8    // ataques de um plano sugerido, no máximo
+#define LARGURA_PLANO 12      // candidatos explorados em cada nível da busca do planejador
+#define NOS_PLANO 5000        // nós visitados por subárvore da raiz do planejador, no máximo
+#define TROPAS_CADEIA 8              // teto padrão de tropas por território (reforços e remanejamentos) da análise exata
+#define MAX_ESTADOS_CADEIA (1u << 22) // estados transientes da análise exata, no máximo
+#define TOLERANCIA_CADEIA 1e-12      // critério de parada do Gauss-Seidel da análise exata
+#define ITERACOES_CADEIA 100000      // varreduras do Gauss-Seidel, no máximo
+#define ETAPA_FIM_TURNO UINT8_MAX    // etapa das subposições de turno encerrado na análise exata
+#define COLUNAS_CADEIA(J) ((J) + 2)  // colunas por estado da análise exata: jogadores, "preso no teto" e "sem fim"
+#define BLOCOS_IMPORTANCIA 64        // blocos independentes (um gerador cada) da amostragem por importância
+#define AMOSTRAS_PILOTO 4000         // amostras de cada inclinação testada na escolha automática
+#define INCLINACAO_MAXIMA 3.0        // maior inclinação dos dados testada (em módulo)
+#define PARTIDAS_VARREDURA 20        // partidas por configuração na varredura de parâmetros (padrão)
+#define MAX_CONFIGURACOES_VARREDURA 100000 // configurações de uma varredura, no máximo
+#define PERMUTACOES_DONOS 120        // distribuições de donos do mapa padrão (5! ordens dos exércitos)
+#define LOTE_BALANCEAMENTO 20        // partidas por candidato em cada rodada da corrida do balanceador
+#define PARTIDAS_BALANCEAMENTO 200   // partidas por candidato do balanceador, no máximo (padrão)
+#define ITERACOES_BALANCEAMENTO 20   // passos do balanceador, no máximo (padrão)
+#define TOLERANCIA_BALANCEAMENTO 0.1 // desequilíbrio aceito pelo balanceador (padrão)
+#define INTERVALO_CONTROLE 10        // partidas entre dois pontos de controle do simulador (padrão)
+#define LOTE_SIMULACAO 64            // partidas do simulador jogadas em paralelo antes de somar os resultados
+#define BITS_SUBFAIXAS_HDR 7         // histogramas HDR: valores até 2^7 exatos, depois erro relativo < 1/64
+#define FAIXAS_HDR ((34 - BITS_SUBFAIXAS_HDR) << (BITS_SUBFAIXAS_HDR - 1)) // faixas para valores de 32 bits
+#define COMPRESSAO_TDIGEST 200       // t-digest: δ, a compressão (da ordem de δ centroides)
+#define PENDENTES_TDIGEST 400        // t-digest: valores guardados antes de cada compressão
+#define PARTIDAS_CALOR 100           // partidas do mapa de calor de conquistas (padrão)
+#define BLOCOS_CALOR 16              // blocos de partidas (com contadores próprios) do mapa de calor
+#define MAGICA_CONTROLE "WARCTRL1"   // assinatura do arquivo de ponto de controle
+#define MAGICA_COLUNA "WARCOL01"     // assinatura dos arquivos da exportação colunar
+#define LINHAS_BLOCO_COLUNA 4096     // partidas por bloco da exportação colunar, no máximo
+#define MAX_GRUPOS_CONSULTA 65536    // valores distintos possíveis da coluna agrupada por uma consulta, no máximo
+#define ALINHAMENTO_ARENA 16         // alinhamento (bytes) de toda fatia entregue por uma arena
+#define BLOCO_ARENA 65536            // primeiro bloco (bytes) de uma arena criada sem capacidade inicial
+#define PARTIDAS_ALOCACOES 3         // partidas da verificação de alocações (padrão)
+#define TERRITORIOS_ALOCACOES 96     // territórios do mapa gerado da verificação de alocações (padrão)
+#define PILHAS_ALOCACAO 8            // pilhas de chamadas guardadas pela verificação de alocações, no máximo
+#define PROFUNDIDADE_PILHA 32        // quadros de cada pilha guardada
 
 // --- Estrutura de Dados ---
-// Define a estrutura para um território, contendo seu nome, a cor do exército que o domina e o número de tropas.
+// Define a estrutura para um território, contendo seu nome, o exército que o domina e o número de tropas.
+// 'dono' é o ID do exército (índice em jogo->nomesJogadores) e 'continente' o índice do continente a que pertence.
 typedef struct {
     char nome[TAM_NOME];
-    char corExercito[TAM_COR];
     int tropas;
+    int dono;
+    int continente;
 } Territorio;
 
+// Define um continente: quem dominar todos os seus territórios recebe 'bonus' tropas extras no reforço.
+typedef struct {
+    char nome[TAM_NOME];
+    int bonus;
+    int totalTerritorios;
+} Continente;
+
+// Configuração inicial do mapa padrão: tropas e exército dono de cada território (usada por inicializarTerritorios()).
+typedef struct {
+    int tropas[TOTAL_TERRITORIOS];
+    int donos[TOTAL_TERRITORIOS];
+} ConfiguracaoInicial;
+
+// Nomes dos territórios do mapa padrão.
+static const char *nomesTerritorios[TOTAL_TERRITORIOS] = {"Amazonas", "Cerrado", "Pantanal", "Caatinga", "Mata Atlantica"};
+
+// Configuração do mapa padrão: um território para cada exército (Verde, Azul, Vermelho, Amarelo, Roxo).
+static const ConfiguracaoInicial configuracaoPadrao = {{5, 4, 6, 3, 5}, {0, 1, 2, 3, 4}};
+
+// Estatísticas acumuladas de um jogador durante a partida (uma entrada por ID de jogador).
+typedef struct {
+    int rolagens;          // rolagens de dados feitas atacando
+    int batalhas;          // blitz feitas atacando
+    int conquistas;        // territórios conquistados
+    int tropasPerdidas;    // tropas perdidas atacando ou defendendo
+    int tropasDestruidas;  // tropas inimigas destruídas
+    int eliminadoNaRodada; // rodada em que perdeu o último território (0 = ainda no jogo)
+    double sorte;          // conquistas acima do esperado nas blitz (resultado menos a chance exata)
+} EstatisticasJogador;
+
+// Entrada do índice de nomes: os territórios ficam ordenados pelo nome (sem diferenciar maiúsculas e
+// tratando '_' como espaço) para que comandos por nome sejam resolvidos por busca binária.
+typedef struct {
+    const char *nome;
+    int territorio;
+} EntradaNome;
+
+// Resultado de uma rolagem: quantas tropas cada lado perde.
+typedef struct {
+    int perdasAtacante;
+    int perdasDefensor;
+} ResultadoRolagem;
+
+// Gerador pseudoaleatório do jogo (xoshiro256**): rápido, com estado próprio e sem o viés de rand() % 6.
+// 'inverter' é aplicado (xor) a cada saída: com todos os bits ligados a sequência vira a antitética
+// (cada u uniforme vira 1 - u, cada dado d vira 7 - d), com a mesma distribuição.
+typedef struct {
+    uint64_t s[4];
+    uint64_t inverter;
+} GeradorAleatorio;
+
+// Kernel de combate: rola e compara os dados de uma rolagem. Cada combinação de regras que afeta o
+// laço interno (dados de cada lado, empate, perda do atacante) tem seu próprio kernel especializado
+// em tempo de compilação; 'nAtaque' e 'nDefesa' são os dados que cada lado poderia rolar pelas tropas.
+// Os vetores de saída recebem os dados rolados (MAX_DADOS posições, zeros nas não usadas).
+typedef ResultadoRolagem (*KernelCombate)(GeradorAleatorio *rng, int nAtaque, int nDefesa, int *dadosAtaque, int *dadosDefesa);
+
+// Define uma variante de regras de combate: quantos dados cada lado rola e como empates são resolvidos.
+// A regra original do desafio (1 dado contra 1, empate do atacante) e a regra clássica do WAR
+// (até 3 dados de cada lado, pares comparados em ordem decrescente) são apenas parametrizações diferentes.
+// O kernel é escolhido uma única vez por partida em prepararRegras().
+typedef struct {
+    const char *nome;
+    int dadosAtaque;       // máximo de dados do atacante (1..MAX_DADOS)
+    int dadosDefesa;       // máximo de dados do defensor (1..MAX_DADOS)
+    int empateAtacante;    // 1 se empates favorecem o atacante
+    int atacantePerde;     // 1 se o atacante perde tropas quando a defesa vence um par
+    int guarnicao;         // tropas que precisam ficar no território atacante
+    int minimoConquista;   // tropas movidas para o território conquistado (no mínimo)
+    KernelCombate kernel;  // kernel especializado para esta combinação de regras
+} Regras;
+
+// Variantes de regras disponíveis (a primeira é a padrão).
+static const Regras variantesRegras[] = {
+    {"original", 1, 1, 1, 0, 0, 1, NULL}, // regra do desafio: só o defensor perde tropas
+    {"classica", 3, 3, 0, 1, 1, 1, NULL}, // WAR: atacante até 3 dados, defensor até 3, empate da defesa
+    {"risk",     3, 2, 0, 1, 1, 1, NULL}, // Risk: atacante até 3 dados, defensor até 2, empate da defesa
+};
+#define TOTAL_VARIANTES (sizeof(variantesRegras) / sizeof(variantesRegras[0]))
+
+// Tipos de missão do catálogo.
+typedef enum {
+    MISSAO_DESTRUIR,       // eliminar o exército 'alvo'
+    MISSAO_TERRITORIOS,    // possuir pelo menos 'quantidade' territórios
+    MISSAO_CONTINENTES,    // possuir os continentes 'continente1' e 'continente2' por completo
+    MISSAO_OCUPAR          // possuir 'quantidade' territórios com pelo menos TROPAS_OCUPACAO tropas cada
+} TipoMissao;
+
+// Entrada do catálogo de missões (dados, não código): 'alvo' é um ID de jogador e continentes são índices do mapa.
+typedef struct {
+    TipoMissao tipo;
+    int alvo;
+    int quantidade;
+    int continente1;
+    int continente2;
+} DefinicaoMissao;
+
+// Missão compilada para um jogador: um predicado único sobre os contadores da partida,
+//   minimo <= contadoresMissao[contador] <= maximo  E  (continentesJogador[jogador] & mascara) == mascara,
+// avaliado em tempo constante e sem desvios após cada evento, qualquer que seja o tipo da missão.
+typedef struct {
+    int id;           // índice no catálogo (-1 = sem missão)
+    int jogador;
+    int contador;     // índice em contadoresMissao
+    int minimo;
+    int maximo;
+    uint64_t mascara;
+} MissaoCompilada;
+
+// Tabela de probabilidades de "blitz" (atacar repetidamente até conquistar ou esgotar as tropas que podem atacar).
+// vitoria[a * (MAX_TROPAS_BLITZ + 1) + d] é a probabilidade de um território com 'a' tropas conquistar um com 'd'.
+// probRolagem[nA - 1][nD - 1][k] é a probabilidade de uma rolagem com nA x nD dados custar 'k' tropas ao defensor.
+// Calculada de forma exata (programação dinâmica) uma vez por partida, para as regras da partida.
+typedef struct {
+    double *vitoria;
+    double probRolagem[MAX_DADOS][MAX_DADOS][MAX_DADOS + 1];
+} TabelaBlitz;
+
+// Plano de ataques sugerido: blitz em sequência (cada conquista recebe todas as tropas do atacante menos uma,
+// como em executarBlitz()) e a probabilidade de todos darem certo, que é a de cumprir a missão neste turno.
+typedef struct {
+    int origem[MAX_PASSOS_PLANO];
+    int destino[MAX_PASSOS_PLANO];
+    int total;
+    double probabilidade;
+} PlanoAtaque;
+
+// Mapa de ameaças: para cada território, a chance de ser conquistado no próximo turno dos adversários.
+// É um cache: um território só é recalculado depois que ele ou um vizinho muda de tropas ou de dono
+// (sujo[t] = 1, com 't' anotado uma única vez em 'pendentes').
+typedef struct {
+    double *probabilidade;
+    unsigned char *sujo;
+    int *pendentes;
+    size_t totalPendentes;
+} MapaAmeacas;
+
+// Bloco de memória de uma arena; os dados começam logo depois do cabeçalho.
+typedef struct BlocoArena {
+    struct BlocoArena *anterior;  // bloco aberto antes deste (NULL = o primeiro)
+    size_t tamanho;               // bytes de dados do bloco
+    size_t usado;
+    _Alignas(ALINHAMENTO_ARENA) unsigned char dados[];
+} BlocoArena;
+
+// Arena (alocador por incremento): a memória é pedida ao sistema em blocos grandes e entregue em fatias, sem
+// liberação individual. Tudo volta de uma vez em reiniciarArena() (que mantém os blocos para o próximo uso) ou
+// liberarArena(). Um pedido que não cabe no bloco atual abre um bloco novo, com o dobro do tamanho.
+typedef struct {
+    BlocoArena *atual;
+} Arena;
+
+// Estado de uma partida: mapa, continentes, regras e contadores mantidos incrementalmente.
+// posseContinente[c * totalJogadores + j] guarda quantos territórios do continente 'c' o jogador 'j' possui;
+// bonusJogador[j] é a soma dos bônus dos continentes completos de 'j' e territoriosJogador[j] quantos territórios
+// 'j' possui. Todos são atualizados apenas na troca de dono (transferirTerritorio()), nunca por varredura do mapa.
+// A vizinhança fica em formato compacto: os vizinhos de 't' são vizinhos[inicioVizinhos[t] .. inicioVizinhos[t + 1]).
+// As regiões conexas de cada jogador (territórios próprios ligados por fronteiras próprias) formam uma floresta
+// união-busca em paiRegiao/rankRegiao; a lista encadeada proximoDoJogador/anteriorDoJogador/primeiroDoJogador
+// permite reconstruir só as regiões do jogador afetado quando uma conquista parte uma região ao meio.
+// contadoresMissao guarda, em sequência, territoriosJogador[] e ocupadosJogador[] (territórios com ao menos
+// TROPAS_OCUPACAO tropas) para que as missões compiladas apontem para qualquer contador por um único índice;
+// continentesJogador[j] tem um bit por continente completo de 'j'.
+// Jogadores são IDs inteiros (0 .. totalJogadores - 1); nomesJogadores[j] e estatisticas[j] são indexados pelo ID,
+// e o catálogo de missões é montado para o mapa e a quantidade de jogadores da partida.
+// indiceNomes tem os territórios ordenados por nome, montado uma única vez quando o mapa é carregado.
+// A fronteira de cada jogador (territórios próprios vizinhos de algum inimigo) é a lista encadeada
+// proximoNaFronteira/anteriorNaFronteira/primeiroNaFronteira, com tamanhoFronteira[j] elementos;
+// inimigosVizinhos[t] conta os vizinhos de 't' com outro dono, e 't' está na fronteira do dono se e só se
+// inimigosVizinhos[t] > 0. Numa troca de dono só o território e seus vizinhos são atualizados.
+// 'ameacas' é um cache mutável mesmo em consultas a um Jogo constante (por isso fica atrás de um ponteiro).
+// limiarAtaque[j] é a chance mínima de conquista para o exército automático 'j' atacar
+// (LIMIAR_ATAQUE_AUTOMATICO por padrão; o simulador muda a de um jogador para comparar estratégias).
+// trocasDono[t] e rodadaTroca[t] (opcionais, NULL = desligados; usados pelo mapa de calor) contam as trocas de dono
+// de cada território e guardam a rodada da última.
+// Todos os vetores da partida saem da arena 'memoria', devolvida de uma vez por liberarMemoria(). 'rascunho' é a
+// arena das alocações temporárias de um turno (otimizador de reforço, planejador), reiniciada ao fim de cada turno:
+// depois de montada a partida, jogar turnos não pede memória ao sistema. Como 'ameacas', fica atrás de um ponteiro
+// porque é usada também a partir de um Jogo constante.
+typedef struct {
+    Territorio *territorios;
+    size_t total;
+    Continente *continentes;
+    size_t totalContinentes;
+    EntradaNome *indiceNomes;
+    int totalJogadores;
+    char (*nomesJogadores)[TAM_COR];
+    EstatisticasJogador *estatisticas;
+    DefinicaoMissao *catalogo;
+    int totalMissoes;
+    int rodada;
+    size_t *inicioVizinhos;
+    int *vizinhos;
+    int *posseContinente;
+    int *bonusJogador;
+    int *contadoresMissao;
+    int *territoriosJogador;
+    int *ocupadosJogador;
+    uint64_t *continentesJogador;
+    MissaoCompilada *missoes;
+    int *paiRegiao;
+    int *rankRegiao;
+    int *proximoDoJogador;
+    int *anteriorDoJogador;
+    int *primeiroDoJogador;
+    int *inimigosVizinhos;
+    int *proximoNaFronteira;
+    int *anteriorNaFronteira;
+    int *primeiroNaFronteira;
+    int *tamanhoFronteira;
+    MapaAmeacas *ameacas;
+    double *limiarAtaque;
+    int limiteTropas;           // teto de tropas por território nos reforços e remanejamentos automáticos
+                                // (INT32_MAX = sem teto; a análise exata usa um teto para a cadeia ser finita)
+    int *trocasDono;
+    int *rodadaTroca;
+    Arena memoria;
+    Arena *rascunho;
+    Regras regras;
+    TabelaBlitz blitz;
+    GeradorAleatorio rng;
+} Jogo;
+
+// Colunas da exportação colunar do simulador: um arquivo DIRETORIO/<nome>.col por coluna, com uma linha por partida.
+enum {
+    COLUNA_SEMENTE,      // semente da partida (8 bytes, sem sinal)
+    COLUNA_VENCEDOR,     // ID do vencedor (-1 = sem vencedor)
+    COLUNA_MISSAO,       // ID no catálogo da missão do vencedor (-1 = sem vencedor)
+    COLUNA_TIPO,         // tipo da missão do vencedor (TipoMissao; -1 = sem vencedor)
+    COLUNA_RODADAS,      // rodada em que a partida terminou
+    COLUNA_BLITZ,        // blitz da partida, somadas entre todos os exércitos
+    COLUNA_ANTITETICA,   // 1 na cópia antitética de um par (--antiteticas; mesma semente), 0 na partida original
+    COLUNA_TERRITORIOS,  // territórios de cada exército no fim (um valor por exército em cada linha)
+    TOTAL_COLUNAS
+};
+
+// Cabeçalho de um arquivo de coluna, seguido de blocos (CabecalhoBloco + valores), sempre no formato binário
+// desta máquina. Cada linha tem 'largura' valores de 'bytesValor' bytes: 8 = inteiro sem sinal, 4 = com sinal.
+typedef struct {
+    char magica[8];          // MAGICA_COLUNA (sem o '\0')
+    uint32_t largura;
+    uint32_t bytesValor;
+} CabecalhoColuna;
+
+// Cabeçalho de um bloco: quantas linhas ele tem e o menor e o maior valor (estendidos para 64 bits, com sinal
+// nas colunas de 4 bytes), para que consultas pulem blocos inteiros sem ler os valores.
+typedef struct {
+    uint32_t linhas;
+    uint32_t reservado;
+    uint64_t minimo;
+    uint64_t maximo;
+} CabecalhoBloco;
+
+// Estimativa da chance de conquista de uma blitz por amostragem por importância.
+typedef struct {
+    double probabilidade;     // média dos pesos das amostras que conquistaram
+    double erroPadrao;        // erro padrão da média
+    double amostrasEfetivas;  // (soma dos pesos)² / soma dos quadrados dos pesos
+    long long acertos;        // amostras que conquistaram
+    long long amostras;       // amostras sorteadas
+} EstimativaRara;
+
+// Tarefa executada em paralelo: processa o item 'indice' de um lote de trabalho.
+typedef void (*TarefaParalela)(void *contexto, size_t indice);
+
+// Nomes dos exércitos clássicos (IDs 0 a 4); os demais jogadores recebem nomes numerados.
+static const char *nomesExercitos[TOTAL_JOGADORES] = {"Verde", "Azul", "Vermelho", "Amarelo", "Roxo"};
+
+// Nomes (e arquivos) das colunas da exportação colunar.
+static const char *nomesColunas[TOTAL_COLUNAS] = {"semente", "vencedor", "missao", "tipo", "rodadas", "blitz",
+                                                  "antitetica", "territorios"};
+
+// Cores dos exércitos clássicos em RGB (valores exatos da paleta de 256 cores); as demais são geradas pelo ID.
+static const unsigned char coresClassicas[TOTAL_JOGADORES][3] = {
+    {0, 175, 0}, {0, 95, 255}, {255, 0, 0}, {255, 255, 0}, {175, 0, 255}};
+
 // Códigos ANSI para cores no terminal (uso opcional em terminais compatíveis)
-static const char *coresANSI[] = {"\033[32m", "\033[34m", "\033[31m", "\033[33m", "\033[35m"};
 static const char *resetANSI = "\033[0m";
 
 // --- Protótipos das Funções ---
 // Declarações antecipadas de todas as funções que serão usadas no programa, organizadas por categoria.
 
 // Funções de setup e gerenciamento de memória:
-Territorio *alocarMapa(size_t total);
-void inicializarTerritorios(Territorio *territorios, size_t total);
-void liberarMemoria(Territorio *territorios);
+int criarJogo(Jogo *jogo, const Regras *regras, uint64_t semente);
+int criarJogoConfigurado(Jogo *jogo, const Regras *regras, uint64_t semente, const ConfiguracaoInicial *config);
+int criarJogoGerado(Jogo *jogo, const Regras *regras, uint64_t semente, size_t territorios, int jogadores);
+Territorio *alocarMapa(Arena *arena, size_t total);
+void inicializarTerritorios(Territorio *territorios, size_t total, const ConfiguracaoInicial *config);
+void inicializarContinentes(Continente *continentes, size_t total);
+int gerarMapa(Jogo *jogo);
+int montarVizinhanca(Jogo *jogo, const int (*fronteiras)[2], size_t totalFronteiras);
+void liberarMemoria(Jogo *jogo);
+int criarArena(Arena *arena, size_t capacidade);
+void *alocarArena(Arena *arena, size_t quantidade, size_t tamanho);
+void reiniciarArena(Arena *arena);
+void liberarArena(Arena *arena);
 
 // Funções de interface com o usuário:
 void exibirMenuPrincipal(void);
-void exibirMapa(const Territorio *territorios, size_t total);
-void exibirMissao(int idMissao, const char *alvoMissao);
+void exibirMapa(const Jogo *jogo, unsigned colunas);
+void exibirMissao(const Jogo *jogo, int jogador);
 
 // Funções de lógica principal do jogo:
-void faseDeAtaque(Territorio *territorios, size_t total, const char *corJogador);
-void simularAtaque(Territorio *atacante, Territorio *defensor, const char *corJogador);
-int sortearMissao(char *descricao, size_t descSize, char *alvoMissao, size_t alvoSize, const char *corJogador);
-int verificarVitoria(const Territorio *territorios, size_t total, int idMissao, const char *alvoMissao, const char *corJogador);
+void faseDeAtaque(Jogo *jogo, int jogador);
+int validarAtaque(const Jogo *jogo, int jogador, int idxAtacante, int idxDefensor);
+int executarComando(Jogo *jogo, int jogador, char *linha);
+void simularAtaque(Jogo *jogo, size_t idxAtacante, size_t idxDefensor);
+ResultadoRolagem rolarAtaque(Jogo *jogo, size_t idxAtacante, size_t idxDefensor, int *dadosAtaque, int *dadosDefesa);
+int conquistarTerritorio(Jogo *jogo, size_t idxAtacante, size_t idxDefensor, int mover);
+int executarBlitz(Jogo *jogo, size_t idxAtacante, size_t idxDefensor);
+void transferirTerritorio(Jogo *jogo, size_t idx, int novoDono);
+void alterarTropas(Jogo *jogo, size_t idx, int delta);
+int faseDeReforco(Jogo *jogo, int jogador); // 0 se a entrada acabou
+void reforcarOponentes(Jogo *jogo, int jogadorHumano);
+int faseDeFortificacao(Jogo *jogo, int jogador);
+int moverTropas(Jogo *jogo, size_t origem, size_t destino, int quantidade);
+int sortearMissao(Jogo *jogo, int jogador);
+void distribuirMissoes(Jogo *jogo);
+int verificarVitoria(const Jogo *jogo, int jogador);
+
+// Funções do catálogo de missões:
+int montarCatalogo(Jogo *jogo);
+void compilarMissao(const Jogo *jogo, int idCatalogo, int jogador, MissaoCompilada *missao);
+void descreverMissao(const Jogo *jogo, const MissaoCompilada *missao, char *descricao, size_t descSize);
+
+// Funções de combate (dados e regras):
+const Regras *buscarRegras(const char *nome);
+int prepararRegras(Regras *regras);
+ResultadoRolagem compararDados(const int *dadosAtaque, const int *dadosDefesa, int nAtaque, int nDefesa, const Regras *regras);
 
-// Função utilitária:
+// Funções de vizinhança e regiões conexas:
+int montarIndiceNomes(Jogo *jogo);
+int buscarTerritorio(const Jogo *jogo, const char *nome);
+int saoVizinhos(const Jogo *jogo, size_t a, size_t b);
+int encontrarRegiao(const Jogo *jogo, size_t idx);
+int mesmaRegiao(const Jogo *jogo, size_t a, size_t b);
+void unirRegioes(Jogo *jogo, size_t a, size_t b);
+void reconstruirRegioes(Jogo *jogo, int jogador);
+void inserirNaFronteira(Jogo *jogo, size_t idx);
+void removerDaFronteira(Jogo *jogo, size_t idx);
+void atualizarFronteira(Jogo *jogo, size_t idx, int antigo);
+
+// Funções de reforço e probabilidades de ataque:
+int calcularReforcos(const Jogo *jogo, int jogador);
+void otimizarReforco(const Jogo *jogo, int jogador, int tropas, int *alocacao);
+int calcularTabelaBlitz(TabelaBlitz *tabela, const Regras *regras);
+double probabilidadeBlitz(const TabelaBlitz *tabela, int tropasAtaque, int tropasDefesa);
+void invalidarAmeaca(Jogo *jogo, size_t idx);
+const double *atualizarAmeacas(const Jogo *jogo);
+
+// Funções do planejador de ataques:
+int planejarAtaques(const Jogo *jogo, int jogador, PlanoAtaque *plano);
+
+// Funções de simulação (partidas entre exércitos automáticos):
+int jogarTurnoAutomatico(Jogo *jogo, int jogador);
+size_t capacidadeRascunho(size_t total);
+int simularPartida(Jogo *jogo, int limiteRodadas);
+int continuarPartida(Jogo *jogo, int limiteRodadas);
+int executarSimulacoes(int argc, char *argv[]);
+int executarVarredura(int argc, char *argv[]);
+int executarBalanceamento(int argc, char *argv[]);
+int executarConsulta(int argc, char *argv[]);
+int executarMapaCalor(int argc, char *argv[]);
+int executarVerificacaoAlocacoes(int argc, char *argv[]);
+
+// Funções de análise exata (cadeia de Markov absorvente):
+int resolverCadeiaMissoes(Jogo *jogo, int jogador, int limiteTropas, double *vitoria, size_t resumo[3]);
+int executarAnaliseExata(int argc, char *argv[]);
+
+// Funções de amostragem por importância (batalhas raras):
+int estimarBlitzRaro(const Regras *regras, int tropasAtaque, int tropasDefesa, double inclinacao, long long amostras,
+                     uint64_t semente, EstimativaRara *estimativa);
+double escolherInclinacao(const Regras *regras, int tropasAtaque, int tropasDefesa, uint64_t semente);
+int executarBatalhaRara(int argc, char *argv[]);
+
+// Execução paralela (pool de threads):
+void definirThreads(int total);
+void executarEmParalelo(size_t n, TarefaParalela tarefa, void *contexto);
+void prepararExecucaoParalela(void);
+void encerrarExecucaoParalela(void);
+
+// Gerador de números aleatórios:
+void semearGerador(GeradorAleatorio *rng, uint64_t semente);
+uint64_t proximoAleatorio(GeradorAleatorio *rng);
+uint32_t sortearIntervalo(GeradorAleatorio *rng, uint32_t n);
+
+// Funções utilitárias:
 void limparBufferEntrada(void);
-int indiceCorParaANSI(const char *cor); // ajuda para cor no terminal (retorna índice ou -1)
+int lerLinha(char *linha, size_t tamanho);
+int converterInteiro(const char *texto, int *valor);
+int converterInteiroLongo(const char *texto, long long *valor);
+int converterNatural(const char *texto, uint64_t *valor);
+int converterReal(const char *texto, double *valor);
+int lerInteiro(int *valor);
+int lerTerritorio(const Jogo *jogo);
+int separarTokens(char *linha, char **tokens, int maxTokens);
+int lerOpcaoRegras(int argc, char *argv[], int *i, Regras *regras);
+int lerOpcaoMapa(int argc, char *argv[], int *i, size_t *territorios, int *jogadores);
+int conferirOpcaoMapa(size_t territorios, int *jogadores);
+int buscarJogador(const Jogo *jogo, const char *nome); // ID do jogador com esse nome (ou -1)
+void codigoCorJogador(int jogador, char *codigo, size_t tamanho); // sequência ANSI da cor do jogador
 
 // --- Função Principal (main) ---
 // Função principal que orquestra o fluxo do jogo, chamando as outras funções em ordem.
-int main(void) {
+int main(int argc, char *argv[]) {
     // 1. Configuração Inicial (Setup):
     // - Define o locale para português.
+    // - Lê a variante de regras de combate da linha de comando (--regras original|classica|risk).
+    // - O subcomando "simular" roda partidas só entre exércitos automáticos (sem interface).
+    // - O subcomando "exato" calcula a chance exata de cada missão ser cumprida (cadeia de Markov absorvente).
+    // - O subcomando "varrer" simula uma grade (ou amostra) de configurações iniciais de tropas e donos.
+    // - O subcomando "balancear" ajusta tropas e donos iniciais até os exércitos vencerem com a mesma chance.
+    // - O subcomando "raro" estima chances muito pequenas de uma blitz (amostragem por importância).
+    // - O subcomando "calor" gera o mapa de calor de conquistas por território (CSV) de muitas partidas.
+    // - O subcomando "consultar" filtra e agrupa a exportação colunar gravada por "simular --colunas".
+    // - O subcomando "alocacoes" verifica que partidas automáticas, depois de montadas, não chamam o alocador.
     // - Inicializa a semente para geração de números aleatórios com base no tempo atual.
     // - Aloca a memória para o mapa do mundo e verifica se a alocação foi bem-sucedida.
     // - Preenche os territórios com seus dados iniciais (tropas, donos, etc.).
     // - Define a cor do jogador e sorteia sua missão secreta.
 
     setlocale(LC_ALL, "");      // define locale (ajuda em ambientes que usam acentuação)
-    srand((unsigned int)time(NULL)); // inicializa aleatoriedade
 
-    // cor do jogador (pode ser parametrizada)
-    const char corJogador[TAM_COR] = "Azul";
+    if (argc > 1 && strcmp(argv[1], "simular") == 0) {
+        int status = executarSimulacoes(argc - 1, argv + 1);
+        encerrarExecucaoParalela();
+        return status;
+    }
+    if (argc > 1 && strcmp(argv[1], "exato") == 0) {
+        int status = executarAnaliseExata(argc - 1, argv + 1);
+        encerrarExecucaoParalela();
+        return status;
+    }
+    if (argc > 1 && strcmp(argv[1], "varrer") == 0) {
+        int status = executarVarredura(argc - 1, argv + 1);
+        encerrarExecucaoParalela();
+        return status;
+    }
+    if (argc > 1 && strcmp(argv[1], "balancear") == 0) {
+        int status = executarBalanceamento(argc - 1, argv + 1);
+        encerrarExecucaoParalela();
+        return status;
+    }
+    if (argc > 1 && strcmp(argv[1], "raro") == 0) {
+        int status = executarBatalhaRara(argc - 1, argv + 1);
+        encerrarExecucaoParalela();
+        return status;
+    }
+    if (argc > 1 && strcmp(argv[1], "calor") == 0) {
+        int status = executarMapaCalor(argc - 1, argv + 1);
+        encerrarExecucaoParalela();
+        return status;
+    }
+    if (argc > 1 && strcmp(argv[1], "consultar") == 0) return executarConsulta(argc - 1, argv + 1);
+    if (argc > 1 && strcmp(argv[1], "alocacoes") == 0) {
+        int status = executarVerificacaoAlocacoes(argc - 1, argv + 1);
+        encerrarExecucaoParalela();
+        return status;
+    }
+
+    // variante de regras (padrão: regra original do desafio), com ajustes opcionais;
+    // --territorios/--jogadores trocam o mapa padrão por um mapa gerado
+    Regras regras = variantesRegras[0];
+    size_t territoriosGerados = 0;
+    int jogadoresGerados = 0;
+    unsigned colunasMapa = 0; // colunas opcionais do mapa (COLUNA_*)
+    for (int i = 1; i < argc; ++i) {
+        int lida = lerOpcaoRegras(argc, argv, &i, &regras);
+        if (lida == 0) lida = lerOpcaoMapa(argc, argv, &i, &territoriosGerados, &jogadoresGerados);
+        if (lida < 0) return EXIT_FAILURE;
+        if (lida > 0) continue;
+        if (strcmp(argv[i], "--ameacas") == 0) {
+            colunasMapa |= COLUNA_AMEACA;
+        } else {
+            fprintf(stderr, "Uso: %s [--regras original|classica|risk] [--dados-ataque N] [--dados-defesa N]\n"
+                            "          [--empate atacante|defensor] [--minimo-conquista N] [--threads N]\n"
+                            "          [--territorios N --jogadores N] [--ameacas]\n"
+                            "       %s simular [opções] (veja '%s simular --ajuda')\n"
+                            "       %s exato [opções] (veja '%s exato --ajuda')\n"
+                            "       %s varrer [opções] (veja '%s varrer --ajuda')\n"
+                            "       %s balancear [opções] (veja '%s balancear --ajuda')\n"
+                            "       %s raro [opções] (veja '%s raro --ajuda')\n"
+                            "       %s calor [opções] (veja '%s calor --ajuda')\n"
+                            "       %s consultar DIRETORIO [opções] (veja '%s consultar --ajuda')\n"
+                            "       %s alocacoes [opções] (veja '%s alocacoes --ajuda')\n",
+                    argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0],
+                    argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!conferirOpcaoMapa(territoriosGerados, &jogadoresGerados)) return EXIT_FAILURE;
+    // escolhe o kernel especializado uma única vez para toda a partida
+    if (!prepararRegras(&regras)) {
+        fprintf(stderr, "Erro: combinação de regras inválida (dados entre 1 e %d, mínimo na conquista >= 1).\n", MAX_DADOS);
+        return EXIT_FAILURE;
+    }
+    printf("Regras de combate: %s (atacante até %d dado(s), defensor até %d, empate do %s)\n",
+           regras.nome, regras.dadosAtaque, regras.dadosDefesa, regras.empateAtacante ? "atacante" : "defensor");
 
-    // aloca e inicializa mapa
-    Territorio *mapa = alocarMapa(TOTAL_TERRITORIOS);
-    if (mapa == NULL) {
-        fprintf(stderr, "Erro: falha ao alocar memória para o mapa.\n");
+    // aloca e inicializa mapa, continentes e contadores (dados de combate usam o gerador próprio do jogo)
+    Jogo jogo;
+    int criado = territoriosGerados > 0
+                     ? criarJogoGerado(&jogo, &regras, (uint64_t)time(NULL), territoriosGerados, jogadoresGerados)
+                     : criarJogo(&jogo, &regras, (uint64_t)time(NULL));
+    if (!criado) {
+        fprintf(stderr, "Erro: não foi possível criar o mapa (2 a %d jogadores, ao menos um território por jogador).\n",
+                MAX_JOGADORES);
         return EXIT_FAILURE;
     }
-    inicializarTerritorios(mapa, TOTAL_TERRITORIOS);
 
-    // sorteia missão
+    // cor do jogador (pode ser parametrizada)
+    const char corJogador[TAM_COR] = "Azul";
+    const int jogadorHumano = buscarJogador(&jogo, corJogador);
+
+    // distribui as missões de todos os exércitos (compiladas para predicados sobre os contadores da partida)
     char descricaoMissao[MISS_DESC_TAM] = {0};
-    char alvoMissao[TAM_COR] = {0}; // por exemplo: "Verde" se missão for destruir exército Verde
-    int idMissao = sortearMissao(descricaoMissao, sizeof(descricaoMissao), alvoMissao, sizeof(alvoMissao), corJogador);
+    distribuirMissoes(&jogo);
+    descreverMissao(&jogo, &jogo.missoes[jogadorHumano], descricaoMissao, sizeof(descricaoMissao));
 
     // 2. Laço Principal do Jogo (Game Loop):
     // - Roda em um loop 'do-while' que continua até o jogador sair (opção 0) ou vencer.
+    // - No início de cada turno, o jogador distribui seus reforços.
     // - A cada iteração, exibe o mapa, a missão e o menu de ações.
     // - Lê a escolha do jogador e usa um 'switch' para chamar a função apropriada:
     //   - Opção 1: Inicia a fase de ataque.
     //   - Opção 2: Verifica se a condição de vitória foi alcançada e informa o jogador.
+    //   - Opção 3: Encerra o turno (os demais exércitos recebem reforços).
+    //   - Opção 4: Move tropas entre territórios próprios conectados (uma vez por turno).
+    //   - Opção 5: Mostra/oculta no mapa a chance de cada território cair no próximo turno.
+    //   - Texto: comando por nome de território (ex.: "atacar Amazonas Pantanal"), útil para replays por script,
+    //     ou "sugerir" para ver o plano de ataques com maior chance de cumprir a missão no turno.
     //   - Opção 0: Encerra o jogo.
+    // - Após cada ação a missão é verificada automaticamente (custo constante).
     // - Pausa a execução para que o jogador possa ler os resultados antes da próxima rodada.
 
     int opcao;
     int venceu = 0;
+    int turno = 1;
+    int reforcoPendente = 1;
+    int fortificou = 0;
     do {
-        exibirMapa((const Territorio *)mapa, TOTAL_TERRITORIOS);
-        exibirMissao(idMissao, alvoMissao);
+        if (reforcoPendente) {
+            exibirMapa(&jogo, colunasMapa);
+            printf("=== Turno %d ===\n", turno);
+            if (!faseDeReforco(&jogo, jogadorHumano)) { // fim da entrada: encerra como a opção 0
+                printf("\nSaindo do jogo...\n");
+                opcao = 0;
+                break;
+            }
+            reforcoPendente = 0;
+        }
+        exibirMapa(&jogo, colunasMapa);
+        exibirMissao(&jogo, jogadorHumano);
 
         exibirMenuPrincipal();
-        if (scanf("%d", &opcao) != 1) { limparBufferEntrada(); opcao = -1; }
-        limparBufferEntrada();
+        char linha[TAM_LINHA];
+        if (!lerLinha(linha, sizeof(linha))) {
+            opcao = 0; // fim da entrada: encerra
+        } else if (!converterInteiro(linha, &opcao)) {
+            // não é número: a linha pode ser um comando por nome (ex.: "atacar Amazonas Pantanal")
+            opcao = executarComando(&jogo, jogadorHumano, linha) ? OPCAO_COMANDO : -1;
+        }
 
         switch (opcao) {
             case 1:
-                faseDeAtaque(mapa, TOTAL_TERRITORIOS, corJogador);
+                faseDeAtaque(&jogo, jogadorHumano);
                 break;
             case 2:
-                if (verificarVitoria((const Territorio *)mapa, TOTAL_TERRITORIOS, idMissao, alvoMissao, corJogador)) {
+                if (verificarVitoria(&jogo, jogadorHumano)) {
                     printf("\nParabéns! Você cumpriu a missão: %s\n", descricaoMissao);
                     venceu = 1;
                 } else {
                     printf("\nMissão NÃO cumprida ainda: %s\n", descricaoMissao);
                 }
                 break;
+            case 3:
+                reforcarOponentes(&jogo, jogadorHumano);
+                turno++;
+                jogo.rodada = turno;
+                reforcoPendente = 1;
+                fortificou = 0;
+                break;
+            case 4:
+                if (fortificou) {
+                    printf("\nVocê já moveu tropas neste turno.\n");
+                } else {
+                    fortificou = faseDeFortificacao(&jogo, jogadorHumano);
+                }
+                break;
+            case 5:
+                colunasMapa ^= COLUNA_AMEACA;
+                printf("\nColuna de ameaças %s.\n", (colunasMapa & COLUNA_AMEACA) ? "ativada" : "desativada");
+                break;
+            case OPCAO_COMANDO:
+                break; // já executado por executarComando()
             case 0:
                 printf("\nSaindo do jogo...\n");
                 break;
             default:
                 printf("\nOpção inválida. Tente novamente.\n");
         }
+        if (!venceu && opcao != 0 && opcao != 2 && verificarVitoria(&jogo, jogadorHumano)) {
+            printf("\nParabéns! Você cumpriu a missão: %s\n", descricaoMissao);
+            venceu = 1;
+        }
 
         if (!venceu && opcao != 0) {
             printf("\nPressione Enter para continuar...");
-            getchar(); // pausa para o jogador ler
+            if (!lerLinha(linha, sizeof(linha))) { // pausa para o jogador ler
+                printf("\nSaindo do jogo...\n");
+                opcao = 0;
+            }
         }
+        reiniciarArena(jogo.rascunho); // memória temporária da ação (otimizador, planejador) volta para a partida
 
     } while (opcao != 0 && !venceu);
 
     // 3. Limpeza:
     // - Ao final do jogo, libera a memória alocada para o mapa para evitar vazamentos de memória.
-    liberarMemoria(mapa);
+    liberarMemoria(&jogo);
+    encerrarExecucaoParalela();
 
     return EXIT_SUCCESS;
 }
 
 // --- Implementação das Funções ---
 
+// nomearJogador():
+// Nome do exército de um ID: os cinco clássicos e, a partir daí, "Exército N" (N = ID + 1).
+static void nomearJogador(int jogador, char *nome, size_t tamanho) {
+    if (jogador < TOTAL_JOGADORES) snprintf(nome, tamanho, "%s", nomesExercitos[jogador]);
+    else snprintf(nome, tamanho, "Exército %d", (unsigned char)jogador + 1); // IDs cabem em um byte
+}
+
+// alocarJogo():
+// Zera a partida e aloca todos os vetores para um mapa de 'total' territórios, 'totalContinentes' continentes e
+// 'totalJogadores' jogadores, na arena da partida, e cria a arena de rascunho já com a capacidade de um turno.
+// Os dados do mapa (territórios, continentes e vizinhança) ficam para quem chama.
+// Retorna 0 se alguma alocação falhar (nada fica alocado nesse caso).
+static int alocarJogo(Jogo *jogo, const Regras *regras, size_t total, size_t totalContinentes, int totalJogadores) {
+    memset(jogo, 0, sizeof(*jogo));
+    jogo->total = total;
+    jogo->totalContinentes = totalContinentes;
+    jogo->totalJogadores = totalJogadores;
+    Arena *a = &jogo->memoria;
+    size_t jogadores = (size_t)totalJogadores;
+    jogo->territorios = alocarMapa(a, jogo->total);
+    jogo->continentes = (Continente *)alocarArena(a, jogo->totalContinentes, sizeof(Continente));
+    jogo->nomesJogadores = (char (*)[TAM_COR])alocarArena(a, jogadores, TAM_COR);
+    jogo->estatisticas = (EstatisticasJogador *)alocarArena(a, jogadores, sizeof(EstatisticasJogador));
+    jogo->posseContinente = (int *)alocarArena(a, jogo->totalContinentes * jogadores, sizeof(int));
+    jogo->bonusJogador = (int *)alocarArena(a, jogadores, sizeof(int));
+    jogo->contadoresMissao = (int *)alocarArena(a, 2 * jogadores, sizeof(int));
+    jogo->continentesJogador = (uint64_t *)alocarArena(a, jogadores, sizeof(uint64_t));
+    jogo->missoes = (MissaoCompilada *)alocarArena(a, jogadores, sizeof(MissaoCompilada));
+    jogo->paiRegiao = (int *)alocarArena(a, jogo->total, sizeof(int));
+    jogo->rankRegiao = (int *)alocarArena(a, jogo->total, sizeof(int));
+    jogo->proximoDoJogador = (int *)alocarArena(a, jogo->total, sizeof(int));
+    jogo->anteriorDoJogador = (int *)alocarArena(a, jogo->total, sizeof(int));
+    jogo->primeiroDoJogador = (int *)alocarArena(a, jogadores, sizeof(int));
+    jogo->inimigosVizinhos = (int *)alocarArena(a, jogo->total, sizeof(int));
+    jogo->proximoNaFronteira = (int *)alocarArena(a, jogo->total, sizeof(int));
+    jogo->anteriorNaFronteira = (int *)alocarArena(a, jogo->total, sizeof(int));
+    jogo->primeiroNaFronteira = (int *)alocarArena(a, jogadores, sizeof(int));
+    jogo->tamanhoFronteira = (int *)alocarArena(a, jogadores, sizeof(int));
+    jogo->ameacas = (MapaAmeacas *)alocarArena(a, 1, sizeof(MapaAmeacas));
+    jogo->limiarAtaque = (double *)alocarArena(a, jogadores, sizeof(double));
+    if (jogo->ameacas != NULL) {
+        jogo->ameacas->probabilidade = (double *)alocarArena(a, jogo->total, sizeof(double));
+        jogo->ameacas->sujo = (unsigned char *)alocarArena(a, jogo->total, sizeof(unsigned char));
+        jogo->ameacas->pendentes = (int *)alocarArena(a, jogo->total, sizeof(int));
+    }
+    jogo->rascunho = (Arena *)alocarArena(a, 1, sizeof(Arena));
+    if (jogo->rascunho != NULL && !criarArena(jogo->rascunho, capacidadeRascunho(jogo->total))) jogo->rascunho = NULL;
+    jogo->regras = *regras;
+    if (jogo->territorios == NULL || jogo->continentes == NULL || jogo->nomesJogadores == NULL ||
+        jogo->estatisticas == NULL || jogo->posseContinente == NULL ||
+        jogo->bonusJogador == NULL || jogo->contadoresMissao == NULL || jogo->continentesJogador == NULL ||
+        jogo->missoes == NULL || jogo->paiRegiao == NULL ||
+        jogo->rankRegiao == NULL || jogo->proximoDoJogador == NULL || jogo->anteriorDoJogador == NULL ||
+        jogo->primeiroDoJogador == NULL || jogo->inimigosVizinhos == NULL || jogo->proximoNaFronteira == NULL ||
+        jogo->anteriorNaFronteira == NULL || jogo->primeiroNaFronteira == NULL || jogo->tamanhoFronteira == NULL ||
+        jogo->ameacas == NULL || jogo->ameacas->probabilidade == NULL || jogo->ameacas->sujo == NULL ||
+        jogo->ameacas->pendentes == NULL || jogo->limiarAtaque == NULL || jogo->rascunho == NULL ||
+        !calcularTabelaBlitz(&jogo->blitz, &jogo->regras)) {
+        liberarMemoria(jogo);
+        return 0;
+    }
+    jogo->territoriosJogador = jogo->contadoresMissao;
+    jogo->ocupadosJogador = jogo->contadoresMissao + jogo->totalJogadores;
+    for (int j = 0; j < jogo->totalJogadores; ++j) {
+        nomearJogador(j, jogo->nomesJogadores[j], TAM_COR);
+        jogo->limiarAtaque[j] = LIMIAR_ATAQUE_AUTOMATICO;
+    }
+    jogo->limiteTropas = INT32_MAX;
+    return 1;
+}
+
+// prepararContadores():
+// Com o mapa já preenchido, calcula uma única vez os contadores de posse, as listas e regiões de cada jogador
+// e monta o índice de nomes e o catálogo de missões. Retorna 0 (liberando a partida) se faltar memória.
+static int prepararContadores(Jogo *jogo) {
+    // contagem inicial (a única varredura completa; depois tudo é incremental)
+    for (int j = 0; j < jogo->totalJogadores; ++j) jogo->primeiroDoJogador[j] = -1;
+    for (size_t i = 0; i < jogo->total; ++i) {
+        const Territorio *t = &jogo->territorios[i];
+        jogo->continentes[t->continente].totalTerritorios++;
+        jogo->territoriosJogador[t->dono]++;
+        if (t->tropas >= TROPAS_OCUPACAO) jogo->ocupadosJogador[t->dono]++;
+        jogo->posseContinente[(size_t)t->continente * jogo->totalJogadores + t->dono]++;
+        // insere no início da lista do dono
+        jogo->anteriorDoJogador[i] = -1;
+        jogo->proximoDoJogador[i] = jogo->primeiroDoJogador[t->dono];
+        if (jogo->primeiroDoJogador[t->dono] >= 0) jogo->anteriorDoJogador[jogo->primeiroDoJogador[t->dono]] = (int)i;
+        jogo->primeiroDoJogador[t->dono] = (int)i;
+    }
+    for (int j = 0; j < jogo->totalJogadores; ++j) {
+        reconstruirRegioes(jogo, j);
+        jogo->primeiroNaFronteira[j] = -1;
+    }
+    for (size_t i = 0; i < jogo->total; ++i) {
+        for (size_t v = jogo->inicioVizinhos[i]; v < jogo->inicioVizinhos[i + 1]; ++v) {
+            jogo->inimigosVizinhos[i] += jogo->territorios[jogo->vizinhos[v]].dono != jogo->territorios[i].dono;
+        }
+        if (jogo->inimigosVizinhos[i] > 0) inserirNaFronteira(jogo, i);
+        invalidarAmeaca(jogo, i);
+    }
+    for (size_t c = 0; c < jogo->totalContinentes; ++c) {
+        for (int j = 0; j < jogo->totalJogadores; ++j) {
+            if (jogo->posseContinente[c * jogo->totalJogadores + j] == jogo->continentes[c].totalTerritorios) {
+                jogo->bonusJogador[j] += jogo->continentes[c].bonus;
+                jogo->continentesJogador[j] |= UINT64_C(1) << c;
+            }
+        }
+    }
+    if (!montarIndiceNomes(jogo) || !montarCatalogo(jogo)) {
+        liberarMemoria(jogo);
+        return 0;
+    }
+    // ninguém começa com missão (sortearMissao() compila a de cada jogador)
+    for (int j = 0; j < jogo->totalJogadores; ++j) compilarMissao(jogo, -1, j, &jogo->missoes[j]);
+    jogo->rodada = 1;
+    return 1;
+}
+
+// criarJogo():
+// Monta uma partida completa no mapa padrão, com a configuração inicial padrão de tropas e donos.
+int criarJogo(Jogo *jogo, const Regras *regras, uint64_t semente) {
+    return criarJogoConfigurado(jogo, regras, semente, &configuracaoPadrao);
+}
+
+// criarJogoConfigurado():
+// Monta uma partida completa no mapa padrão: aloca e inicializa territórios (com as tropas e donos de 'config')
+// e continentes, copia as regras (já preparadas), semeia o gerador de números aleatórios e calcula uma única vez
+// os contadores de posse. Retorna 1 em caso de sucesso ou 0 se alguma alocação falhar (nada fica alocado nesse caso).
+int criarJogoConfigurado(Jogo *jogo, const Regras *regras, uint64_t semente, const ConfiguracaoInicial *config) {
+    if (!alocarJogo(jogo, regras, TOTAL_TERRITORIOS, TOTAL_CONTINENTES, TOTAL_JOGADORES)) return 0;
+    // fronteiras do mapa padrão (pares de índices de territórios vizinhos)
+    static const int fronteiras[TOTAL_FRONTEIRAS][2] = {{0, 1}, {0, 2}, {1, 2}, {1, 3}, {1, 4}, {2, 4}, {3, 4}};
+    if (!montarVizinhanca(jogo, fronteiras, TOTAL_FRONTEIRAS)) {
+        liberarMemoria(jogo);
+        return 0;
+    }
+    inicializarTerritorios(jogo->territorios, jogo->total, config);
+    inicializarContinentes(jogo->continentes, jogo->totalContinentes);
+    semearGerador(&jogo->rng, semente);
+    return prepararContadores(jogo);
+}
+
+// criarJogoGerado():
+// Monta uma partida em um mapa gerado (gerarMapa()) com 'territorios' territórios divididos entre 'jogadores'
+// exércitos (2 a MAX_JOGADORES). O mesmo gerador semeado com 'semente' cria o mapa e depois rola os dados.
+// Retorna 0 se os parâmetros forem inválidos ou faltar memória.
+int criarJogoGerado(Jogo *jogo, const Regras *regras, uint64_t semente, size_t territorios, int jogadores) {
+    if (jogadores < 2 || jogadores > MAX_JOGADORES || territorios < (size_t)jogadores || territorios > INT32_MAX / 4) {
+        return 0;
+    }
+    // continentes em blocos de ~16 territórios, no máximo MAX_CONTINENTES (um bit de máscara cada)
+    size_t lado = 1;
+    while (lado * lado < territorios) lado++;
+    size_t blocos = 1;
+    while ((blocos + 1) * (blocos + 1) <= MAX_CONTINENTES && (blocos + 1) * (blocos + 1) * 16 <= territorios) blocos++;
+    size_t linhas = (territorios + lado - 1) / lado;
+    if (blocos > linhas) blocos = linhas;
+    if (!alocarJogo(jogo, regras, territorios, blocos * blocos, jogadores)) return 0;
+    semearGerador(&jogo->rng, semente);
+    if (!gerarMapa(jogo)) {
+        liberarMemoria(jogo);
+        return 0;
+    }
+    return prepararContadores(jogo);
+}
+
 // alocarMapa():
-// Aloca dinamicamente a memória para o vetor de territórios usando calloc.
+// Aloca o vetor de territórios (zerado) na arena dada, que passa a ser dona dele.
 // Retorna um ponteiro para a memória alocada ou NULL em caso de falha.
-Territorio *alocarMapa(size_t total) {
-    Territorio *m = (Territorio *)calloc(total, sizeof(Territorio));
+Territorio *alocarMapa(Arena *arena, size_t total) {
+    Territorio *m = (Territorio *)alocarArena(arena, total, sizeof(Territorio));
     return m;
 }
 
 // inicializarTerritorios():
-// Preenche os dados iniciais de cada território no mapa (nome, cor do exército, número de tropas).
+// Preenche os dados iniciais de cada território no mapa (nome, exército dono, número de tropas).
+// Tropas e donos vêm de 'config' (configuracaoPadrao ou uma configuração da varredura de parâmetros).
 // Esta função modifica o mapa passado por referência (ponteiro).
-void inicializarTerritorios(Territorio *territorios, size_t total) {
-    // valores padrão iniciais (poderiam ser lidos de arquivo ou gerados aleatoriamente)
-    const char *nomes[TOTAL_TERRITORIOS] = {"Amazonas", "Cerrado", "Pantanal", "Caatinga", "Mata Atlantica"};
-    const char *cores[TOTAL_TERRITORIOS] = {"Verde", "Azul", "Vermelho", "Amarelo", "Roxo"};
-    const int tropas[TOTAL_TERRITORIOS] = {5, 4, 6, 3, 5};
+void inicializarTerritorios(Territorio *territorios, size_t total, const ConfiguracaoInicial *config) {
+    const int continentes[TOTAL_TERRITORIOS] = {0, 1, 1, 2, 2};
 
     for (size_t i = 0; i < total; ++i) {
-        strncpy(territorios[i].nome, nomes[i], TAM_NOME - 1);
+        strncpy(territorios[i].nome, nomesTerritorios[i], TAM_NOME - 1);
         territorios[i].nome[TAM_NOME - 1] = '\0';
-        strncpy(territorios[i].corExercito, cores[i], TAM_COR - 1);
-        territorios[i].corExercito[TAM_COR - 1] = '\0';
-        territorios[i].tropas = tropas[i];
+        territorios[i].tropas = config->tropas[i];
+        territorios[i].dono = config->donos[i];
+        territorios[i].continente = continentes[i];
+    }
+}
+
+// inicializarContinentes():
+// Preenche nome e bônus de cada continente do mapa padrão. A quantidade de territórios de cada
+// continente é contada em prepararContadores() a partir dos próprios territórios.
+void inicializarContinentes(Continente *continentes, size_t total) {
+    const char *nomes[TOTAL_CONTINENTES] = {"Norte", "Centro-Oeste", "Leste"};
+    const int bonus[TOTAL_CONTINENTES] = {1, 2, 2};
+
+    for (size_t i = 0; i < total; ++i) {
+        strncpy(continentes[i].nome, nomes[i], TAM_NOME - 1);
+        continentes[i].nome[TAM_NOME - 1] = '\0';
+        continentes[i].bonus = bonus[i];
+        continentes[i].totalTerritorios = 0;
+    }
+}
+
+// gerarMapa():
+// Gera um mapa para partidas grandes: os territórios ocupam uma grade quase quadrada, cada um faz fronteira com os
+// vizinhos à direita e abaixo (e, às vezes, na diagonal), e os continentes são blocos retangulares da grade
+// (jogo->totalContinentes precisa ser um quadrado, como em criarJogoGerado()). Os territórios são divididos em
+// partes iguais entre os jogadores, em ordem embaralhada, com 1 a 3 tropas cada. Usa o gerador da partida.
+// Retorna 0 se faltar memória.
+int gerarMapa(Jogo *jogo) {
+    size_t total = jogo->total;
+    size_t lado = 1, blocos = 1;
+    while (lado * lado < total) lado++;
+    while (blocos * blocos < jogo->totalContinentes) blocos++;
+    size_t linhas = (total + lado - 1) / lado;
+
+    int (*fronteiras)[2] = (int (*)[2])malloc(3 * total * sizeof(*fronteiras));
+    int *ordem = (int *)malloc(total * sizeof(int));
+    if (fronteiras == NULL || ordem == NULL) {
+        free(fronteiras);
+        free(ordem);
+        return 0;
+    }
+    size_t totalFronteiras = 0;
+    for (size_t i = 0; i < total; ++i) {
+        size_t x = i % lado, y = i / lado;
+        Territorio *t = &jogo->territorios[i];
+        snprintf(t->nome, TAM_NOME, "Territorio %zu", i + 1);
+        t->continente = (int)((y * blocos / linhas) * blocos + x * blocos / lado);
+        t->tropas = 1 + (int)sortearIntervalo(&jogo->rng, 3);
+        if (x + 1 < lado && i + 1 < total) {
+            fronteiras[totalFronteiras][0] = (int)i;
+            fronteiras[totalFronteiras++][1] = (int)(i + 1);
+        }
+        if (i + lado < total) {
+            fronteiras[totalFronteiras][0] = (int)i;
+            fronteiras[totalFronteiras++][1] = (int)(i + lado);
+        }
+        if (x + 1 < lado && i + lado + 1 < total && sortearIntervalo(&jogo->rng, 3) == 0) {
+            fronteiras[totalFronteiras][0] = (int)i;
+            fronteiras[totalFronteiras++][1] = (int)(i + lado + 1);
+        }
+    }
+    for (size_t c = 0; c < jogo->totalContinentes; ++c) {
+        snprintf(jogo->continentes[c].nome, TAM_NOME, "Regiao %zu", c + 1);
     }
+    // donos: embaralhamento Fisher–Yates dos territórios, distribuídos em rodízio
+    for (size_t i = 0; i < total; ++i) ordem[i] = (int)i;
+    for (size_t i = total - 1; i > 0; --i) {
+        size_t k = sortearIntervalo(&jogo->rng, (uint32_t)(i + 1));
+        int tmp = ordem[i];
+        ordem[i] = ordem[k];
+        ordem[k] = tmp;
+    }
+    for (size_t i = 0; i < total; ++i) jogo->territorios[ordem[i]].dono = (int)(i % (size_t)jogo->totalJogadores);
+
+    int ok = montarVizinhanca(jogo, (const int (*)[2])fronteiras, totalFronteiras);
+    free(fronteiras);
+    free(ordem);
+    if (!ok) return 0;
+    // bônus proporcional ao tamanho do continente (o total só é conhecido depois da contagem)
+    for (size_t i = 0; i < total; ++i) jogo->continentes[jogo->territorios[i].continente].bonus++;
+    for (size_t c = 0; c < jogo->totalContinentes; ++c) {
+        jogo->continentes[c].bonus = jogo->continentes[c].bonus / 4 + 1;
+    }
+    return 1;
+}
+
+// montarVizinhanca():
+// Converte a lista de fronteiras (pares não ordenados) no formato compacto de vizinhança do jogo:
+// conta o grau de cada território, acumula os inícios e preenche os vizinhos. Retorna 0 se faltar memória.
+int montarVizinhanca(Jogo *jogo, const int (*fronteiras)[2], size_t totalFronteiras) {
+    jogo->inicioVizinhos = (size_t *)alocarArena(&jogo->memoria, jogo->total + 1, sizeof(size_t));
+    jogo->vizinhos = (int *)alocarArena(&jogo->memoria, 2 * totalFronteiras, sizeof(int));
+    if (jogo->inicioVizinhos == NULL || jogo->vizinhos == NULL) return 0;
+
+    for (size_t f = 0; f < totalFronteiras; ++f) {
+        jogo->inicioVizinhos[fronteiras[f][0] + 1]++;
+        jogo->inicioVizinhos[fronteiras[f][1] + 1]++;
+    }
+    for (size_t t = 0; t < jogo->total; ++t) jogo->inicioVizinhos[t + 1] += jogo->inicioVizinhos[t];
+    // 'livre' reaproveita paiRegiao como cursor de preenchimento (ainda não está em uso)
+    int *livre = jogo->paiRegiao;
+    for (size_t t = 0; t < jogo->total; ++t) livre[t] = (int)jogo->inicioVizinhos[t];
+    for (size_t f = 0; f < totalFronteiras; ++f) {
+        int a = fronteiras[f][0], b = fronteiras[f][1];
+        jogo->vizinhos[livre[a]++] = b;
+        jogo->vizinhos[livre[b]++] = a;
+    }
+    return 1;
 }
 
 // liberarMemoria():
-// Libera a memória previamente alocada para o mapa usando free.
-void liberarMemoria(Territorio *territorios) {
-    free(territorios);
+// Libera a memória da partida: as duas arenas (mapa, contadores e rascunho dos turnos) e a tabela de blitz.
+void liberarMemoria(Jogo *jogo) {
+    if (jogo->rascunho != NULL) liberarArena(jogo->rascunho);
+    liberarArena(&jogo->memoria);
+    free(jogo->blitz.vitoria);
+    jogo->territorios = NULL;
+    jogo->continentes = NULL;
+    jogo->nomesJogadores = NULL;
+    jogo->estatisticas = NULL;
+    jogo->catalogo = NULL;
+    jogo->indiceNomes = NULL;
+    jogo->posseContinente = NULL;
+    jogo->bonusJogador = NULL;
+    jogo->contadoresMissao = NULL;
+    jogo->territoriosJogador = NULL;
+    jogo->ocupadosJogador = NULL;
+    jogo->continentesJogador = NULL;
+    jogo->missoes = NULL;
+    jogo->paiRegiao = NULL;
+    jogo->rankRegiao = NULL;
+    jogo->proximoDoJogador = NULL;
+    jogo->anteriorDoJogador = NULL;
+    jogo->primeiroDoJogador = NULL;
+    jogo->inimigosVizinhos = NULL;
+    jogo->proximoNaFronteira = NULL;
+    jogo->anteriorNaFronteira = NULL;
+    jogo->primeiroNaFronteira = NULL;
+    jogo->tamanhoFronteira = NULL;
+    jogo->ameacas = NULL;
+    jogo->limiarAtaque = NULL;
+    jogo->trocasDono = NULL;
+    jogo->rodadaTroca = NULL;
+    jogo->inicioVizinhos = NULL;
+    jogo->vizinhos = NULL;
+    jogo->rascunho = NULL;
+    jogo->blitz.vitoria = NULL;
+}
+
+// abrirBlocoArena():
+// Abre na arena um bloco novo com ao menos 'minimo' bytes (o dobro do atual, ou BLOCO_ARENA no primeiro).
+// Retorna 0 se faltar memória.
+static int abrirBlocoArena(Arena *arena, size_t minimo) {
+    size_t tamanho = arena->atual != NULL ? 2 * arena->atual->tamanho : BLOCO_ARENA;
+    if (tamanho < minimo) tamanho = minimo;
+    if (tamanho > SIZE_MAX - sizeof(BlocoArena)) return 0;
+    BlocoArena *bloco = (BlocoArena *)malloc(sizeof(BlocoArena) + tamanho);
+    if (bloco == NULL) return 0;
+    bloco->anterior = arena->atual;
+    bloco->tamanho = tamanho;
+    bloco->usado = 0;
+    arena->atual = bloco;
+    return 1;
+}
+
+// criarArena():
+// Prepara uma arena vazia; com 'capacidade' > 0 já abre um bloco desse tamanho. Retorna 0 se faltar memória.
+int criarArena(Arena *arena, size_t capacidade) {
+    arena->atual = NULL;
+    return capacidade == 0 || abrirBlocoArena(arena, capacidade);
+}
+
+// alocarArena():
+// Como calloc: fatia zerada para 'quantidade' elementos de 'tamanho' bytes, alinhada a ALINHAMENTO_ARENA.
+// Não há liberação individual. Retorna NULL se faltar memória.
+void *alocarArena(Arena *arena, size_t quantidade, size_t tamanho) {
+    if (tamanho != 0 && quantidade > (SIZE_MAX - ALINHAMENTO_ARENA) / tamanho) return NULL;
+    size_t bytes = quantidade * tamanho;
+    size_t fatia = (bytes + ALINHAMENTO_ARENA - 1) & ~(size_t)(ALINHAMENTO_ARENA - 1);
+    if (arena->atual == NULL || arena->atual->tamanho - arena->atual->usado < fatia) {
+        if (!abrirBlocoArena(arena, fatia)) return NULL;
+    }
+    void *p = arena->atual->dados + arena->atual->usado;
+    arena->atual->usado += fatia;
+    memset(p, 0, bytes);
+    return p;
+}
+
+// reiniciarArena():
+// Devolve de uma vez toda a memória entregue pela arena. Se ela precisou de mais de um bloco, os blocos viram um
+// só com a soma das capacidades, para que o mesmo uso caiba no próximo ciclo sem novos pedidos ao sistema.
+void reiniciarArena(Arena *arena) {
+    BlocoArena *bloco = arena->atual;
+    if (bloco == NULL) return;
+    if (bloco->anterior == NULL) {
+        bloco->usado = 0;
+        return;
+    }
+    size_t total = 0;
+    while (bloco != NULL) {
+        BlocoArena *anterior = bloco->anterior;
+        total += bloco->tamanho;
+        free(bloco);
+        bloco = anterior;
+    }
+    arena->atual = NULL;
+    abrirBlocoArena(arena, total); // sem memória, o próximo pedido tenta de novo
+}
+
+// liberarArena():
+// Devolve ao sistema todos os blocos da arena, que fica vazia (e pode ser usada de novo).
+void liberarArena(Arena *arena) {
+    while (arena->atual != NULL) {
+        BlocoArena *anterior = arena->atual->anterior;
+        free(arena->atual);
+        arena->atual = anterior;
+    }
 }
 
 // exibirMenuPrincipal():
@@ -184,87 +1145,166 @@ void exibirMenuPrincipal(void) {
     printf("Menu:\n");
     printf("  1 - Atacar\n");
     printf("  2 - Verificar Missão\n");
+    printf("  3 - Encerrar turno\n");
+    printf("  4 - Mover tropas\n");
+    printf("  5 - Mostrar/ocultar ameaças\n");
     printf("  0 - Sair\n");
+    printf("  (ou um comando: atacar <origem> <destino>, sugerir)\n");
     printf("Escolha uma opção: ");
 }
 
 // exibirMapa():
-// Mostra o estado atual de todos os territórios no mapa, formatado como uma tabela.
+// Mostra o estado atual de todos os territórios no mapa, formatado como uma tabela, seguido dos bônus de continente.
 // Usa 'const' para garantir que a função apenas leia os dados do mapa, sem modificá-los.
-void exibirMapa(const Territorio *territorios, size_t total) {
+void exibirMapa(const Jogo *jogo, unsigned colunas) {
+    const Territorio *territorios = jogo->territorios;
+    // coluna opcional: chance de o território ser conquistado no próximo turno (só recalcula o que mudou)
+    const double *ameaca = (colunas & COLUNA_AMEACA) ? atualizarAmeacas(jogo) : NULL;
     printf("\n=== Estado Atual do Mapa ===\n");
-    printf("Idx | Território               | Exército    | Tropas\n");
-    printf("----+---------------------------+-------------+--------\n");
-    for (size_t i = 0; i < total; ++i) {
-        int idxCor = indiceCorParaANSI(territorios[i].corExercito);
-        if (idxCor >= 0) {
-            printf("%3zu | %-25s | %s%-11s%s | %6d\n",
-                   i + 1,
-                   territorios[i].nome,
-                   coresANSI[idxCor],
-                   territorios[i].corExercito,
-                   resetANSI,
-                   territorios[i].tropas);
-        } else {
-            printf("%3zu | %-25s | %-11s | %6d\n",
-                   i + 1,
-                   territorios[i].nome,
-                   territorios[i].corExercito,
-                   territorios[i].tropas);
+    printf("Idx | Território               | Continente   | Exército     | Tropas |%s Vizinhos\n",
+           ameaca ? " Ameaça |" : "");
+    printf("----+---------------------------+--------------+--------------+--------+%s----------\n",
+           ameaca ? "--------+" : "");
+    char cor[24];
+    for (size_t i = 0; i < jogo->total; ++i) {
+        const char *continente = jogo->continentes[territorios[i].continente].nome;
+        codigoCorJogador(territorios[i].dono, cor, sizeof(cor));
+        printf("%3zu | %-25s | %-12s | %s%-12s%s | %6d |",
+               i + 1,
+               territorios[i].nome,
+               continente,
+               cor,
+               jogo->nomesJogadores[territorios[i].dono],
+               cor[0] != '\0' ? resetANSI : "",
+               territorios[i].tropas);
+        if (ameaca) printf(" %5.1f%% |", 100.0 * ameaca[i]);
+        for (size_t v = jogo->inicioVizinhos[i]; v < jogo->inicioVizinhos[i + 1]; ++v) {
+            printf(" %d", jogo->vizinhos[v] + 1);
+        }
+        printf("\n");
+    }
+    for (int j = 0; j < jogo->totalJogadores; ++j) {
+        if (jogo->bonusJogador[j] > 0) {
+            printf("Bônus de continentes do exército %s: +%d\n", jogo->nomesJogadores[j], jogo->bonusJogador[j]);
         }
     }
     printf("\n");
 }
 
 // exibirMissao():
-// Exibe a descrição da missão atual do jogador com base no ID da missão sorteada.
-void exibirMissao(int idMissao, const char *alvoMissao) {
+// Exibe a descrição da missão atual do jogador, gerada a partir da missão compilada.
+void exibirMissao(const Jogo *jogo, int jogador) {
+    char descricao[MISS_DESC_TAM];
+    descreverMissao(jogo, &jogo->missoes[jogador], descricao, sizeof(descricao));
     printf("=== Missão Atual ===\n");
-    if (idMissao == 0) {
-        printf("  Objetivo: Destruir o exército %s\n", alvoMissao);
-    } else if (idMissao == 1) {
-        printf("  Objetivo: Conquistar 3 territórios (ser dono de pelo menos 3 territórios)\n");
-    } else {
-        printf("  Missão desconhecida\n");
-    }
+    printf("  Objetivo: %s\n", descricao);
     printf("\n");
 }
 
 // faseDeAtaque():
 // Gerencia a interface para a ação de ataque, solicitando ao jogador os territórios de origem e destino.
-// Chama a função simularAtaque() para executar a lógica da batalha.
-void faseDeAtaque(Territorio *territorios, size_t total, const char *corJogador) {
+// Chama a função simularAtaque() para executar a lógica da batalha e encerra a fase assim que a missão
+// do jogador for cumprida (a verificação após cada batalha custa tempo constante).
+void faseDeAtaque(Jogo *jogo, int jogador) {
+    size_t total = jogo->total;
     int nAtaques = 1;
     printf("Quantos ataques deseja realizar neste turno? ");
-    if (scanf("%d", &nAtaques) != 1) { limparBufferEntrada(); printf("Entrada inválida. Voltando ao menu.\n"); return; }
-    limparBufferEntrada();
+    int lidos = lerInteiro(&nAtaques);
+    if (lidos == FIM_ENTRADA) return;
+    if (!lidos) { printf("Entrada inválida. Voltando ao menu.\n"); return; }
 
     for (int i = 0; i < nAtaques; ++i) {
         printf("\n>>> Ataque %d de %d <<<\n", i + 1, nAtaques);
-        int atk = 0, def = 0;
-        printf("Escolha o território atacante (1 - %zu): ", total);
-        if (scanf("%d", &atk) != 1) { limparBufferEntrada(); printf("Entrada inválida. Pulando ataque.\n"); continue; }
-        limparBufferEntrada();
-        printf("Escolha o território defensor (1 - %zu): ", total);
-        if (scanf("%d", &def) != 1) { limparBufferEntrada(); printf("Entrada inválida. Pulando ataque.\n"); continue; }
-        limparBufferEntrada();
-
-        if (atk < 1 || atk > (int)total || def < 1 || def > (int)total || atk == def) {
-            printf("Opção inválida (índices fora de intervalo ou territórios iguais). Ataque cancelado.\n");
-            continue;
-        }
+        printf("Escolha o território atacante (1 - %zu ou nome): ", total);
+        int atk = lerTerritorio(jogo);
+        if (atk == FIM_ENTRADA) return;
+        if (atk < 0) { printf("Território não encontrado. Pulando ataque.\n"); continue; }
+        printf("Escolha o território defensor (1 - %zu ou nome): ", total);
+        int def = lerTerritorio(jogo);
+        if (def == FIM_ENTRADA) return;
+        if (def < 0) { printf("Território não encontrado. Pulando ataque.\n"); continue; }
+        if (!validarAtaque(jogo, jogador, atk, def)) continue;
 
         // executa ataque
-        simularAtaque(&territorios[atk - 1], &territorios[def - 1], corJogador);
+        simularAtaque(jogo, (size_t)atk, (size_t)def);
+        if (verificarVitoria(jogo, jogador)) return;
+    }
+}
+
+// validarAtaque():
+// Confere se o jogador pode atacar entre dois territórios (índices a partir de 0), explicando o motivo se não puder.
+int validarAtaque(const Jogo *jogo, int jogador, int idxAtacante, int idxDefensor) {
+    if (jogo->territorios[idxAtacante].dono != jogador) {
+        printf("Escolha um território atacante seu.\n");
+        return 0;
+    }
+    if (idxAtacante == idxDefensor) {
+        printf("Opção inválida (territórios iguais). Ataque cancelado.\n");
+        return 0;
+    }
+    if (!saoVizinhos(jogo, (size_t)idxAtacante, (size_t)idxDefensor)) {
+        printf("Os territórios não fazem fronteira. Ataque cancelado.\n");
+        return 0;
+    }
+    if (jogo->territorios[idxAtacante].dono == jogo->territorios[idxDefensor].dono) {
+        printf("Não é possível atacar um território do próprio exército. Ataque cancelado.\n");
+        return 0;
+    }
+    return 1;
+}
+
+// executarComando():
+// Interpreta uma linha de comando com territórios por nome ou índice (nomes com espaço vão entre aspas
+// ou com '_' no lugar do espaço):
+//   atacar|attack <atacante> <defensor>   executa um ataque a partir de um território do jogador
+//   sugerir|suggest                       mostra o plano de ataques com maior chance de cumprir a missão no turno
+// Retorna 0 se a linha não for um comando conhecido; comandos conhecidos mas inválidos explicam o erro.
+int executarComando(Jogo *jogo, int jogador, char *linha) {
+    char *tokens[MAX_TOKENS];
+    int n = separarTokens(linha, tokens, MAX_TOKENS);
+    if (n == 0) return 0;
+    if (strcmp(tokens[0], "atacar") == 0 || strcmp(tokens[0], "attack") == 0) {
+        if (n != 3) {
+            printf("Uso: atacar <território atacante> <território defensor>\n");
+            return 1;
+        }
+        int atk = buscarTerritorio(jogo, tokens[1]);
+        int def = buscarTerritorio(jogo, tokens[2]);
+        if (atk < 0 || def < 0) {
+            printf("Território não encontrado: %s\n", atk < 0 ? tokens[1] : tokens[2]);
+            return 1;
+        }
+        if (validarAtaque(jogo, jogador, atk, def)) simularAtaque(jogo, (size_t)atk, (size_t)def);
+        return 1;
+    }
+    if (strcmp(tokens[0], "sugerir") == 0 || strcmp(tokens[0], "suggest") == 0) {
+        PlanoAtaque plano;
+        if (!planejarAtaques(jogo, jogador, &plano)) {
+            printf("Nenhum plano de até %d ataques cumpre a missão neste turno.\n", MAX_PASSOS_PLANO);
+        } else if (plano.total == 0) {
+            printf("A missão já está cumprida.\n");
+        } else {
+            printf("Plano sugerido (atacar até conquistar, movendo todas as tropas menos uma):\n");
+            for (int i = 0; i < plano.total; ++i) {
+                printf("  %d. atacar \"%s\" \"%s\"\n", i + 1, jogo->territorios[plano.origem[i]].nome,
+                       jogo->territorios[plano.destino[i]].nome);
+            }
+            printf("Chance de cumprir a missão neste turno: %.1f%%\n", 100.0 * plano.probabilidade);
+        }
+        return 1;
     }
+    return 0;
 }
 
 // simularAtaque():
 // Executa a lógica de uma batalha entre dois territórios.
-// Realiza validações, rola os dados, compara os resultados e atualiza o número de tropas.
-// Se um território for conquistado, atualiza seu dono e move uma tropa.
-void simularAtaque(Territorio *atacante, Territorio *defensor, const char *corJogador) {
-    if (atacante->tropas <= 0) {
+// Realiza validações, rola os dados conforme a variante de regras, compara os resultados e atualiza o número de tropas.
+// Se um território for conquistado, atualiza seu dono (e os contadores de continente) e move tropas.
+void simularAtaque(Jogo *jogo, size_t idxAtacante, size_t idxDefensor) {
+    Territorio *atacante = &jogo->territorios[idxAtacante];
+    Territorio *defensor = &jogo->territorios[idxDefensor];
+    const Regras *regras = &jogo->regras;
+    if (atacante->tropas <= regras->guarnicao) {
         printf("Território atacante '%s' não tem tropas suficientes.\n", atacante->nome);
         return;
     }
@@ -273,117 +1313,4853 @@ void simularAtaque(Territorio *atacante, Territorio *defensor, const char *corJo
         return;
     }
 
-    // Rolar dados (1..6)
-    int dadoAtaque = rand() % 6 + 1;
-    int dadoDefesa  = rand() % 6 + 1;
-
     printf("%s (tropas: %d, exército: %s) ataca %s (tropas: %d, exército: %s)\n",
-           atacante->nome, atacante->tropas, atacante->corExercito,
-           defensor->nome, defensor->tropas, defensor->corExercito);
-    printf("Rolagem: atacante %d vs defensor %d\n", dadoAtaque, dadoDefesa);
-
-    if (dadoAtaque >= dadoDefesa) {
-        // atacante vence (empates favorecem atacante)
-        defensor->tropas -= 1;
-        printf("Resultado: %s perde 1 tropa (agora %d).\n", defensor->nome, defensor->tropas);
-        if (defensor->tropas <= 0) {
-            // conquista: mudar dono e mover 1 tropa do atacante (mínimo)
-            printf("Território %s foi conquistado por %s!\n", defensor->nome, atacante->corExercito);
-            // atualiza cor para cor do atacante
-            strncpy(defensor->corExercito, atacante->corExercito, TAM_COR - 1);
-            defensor->corExercito[TAM_COR - 1] = '\0';
-            // mover 1 tropa do atacante para o defensor (se possível)
-            if (atacante->tropas > 1) {
-                atacante->tropas -= 1;
-                defensor->tropas = 1;
-                printf("Uma tropa foi movida de %s para %s.\n", atacante->nome, defensor->nome);
-            } else {
-                // se atacante só tinha 1 tropa, defender fica com 1 (já está) e atacante fica 0
-                defensor->tropas = 1;
-                atacante->tropas = 0;
-            }
-        }
-    } else {
-        // defensor vence
+           atacante->nome, atacante->tropas, jogo->nomesJogadores[atacante->dono],
+           defensor->nome, defensor->tropas, jogo->nomesJogadores[defensor->dono]);
+
+    // Rolar dados (1..6): o kernel especializado limita a quantidade conforme as regras
+    int dadosAtaque[MAX_DADOS];
+    int dadosDefesa[MAX_DADOS];
+    ResultadoRolagem r = rolarAtaque(jogo, idxAtacante, idxDefensor, dadosAtaque, dadosDefesa);
+
+    printf("Rolagem: atacante");
+    for (int i = 0; i < MAX_DADOS && dadosAtaque[i] > 0; ++i) printf(" %d", dadosAtaque[i]);
+    printf(" vs defensor");
+    for (int i = 0; i < MAX_DADOS && dadosDefesa[i] > 0; ++i) printf(" %d", dadosDefesa[i]);
+    printf("\n");
+
+    if (r.perdasDefensor > 0) {
+        printf("Resultado: %s perde %d tropa(s) (agora %d).\n", defensor->nome, r.perdasDefensor, defensor->tropas);
+    }
+    if (r.perdasAtacante > 0) {
+        printf("Resultado: %s perde %d tropa(s) (agora %d).\n", atacante->nome, r.perdasAtacante, atacante->tropas);
+    }
+    if (r.perdasDefensor == 0 && r.perdasAtacante == 0) {
+        // defensor vence sem custo para o atacante (regra original)
         printf("Resultado: defesa bem sucedida. Nenhuma perda do defensor.\n");
     }
 
+    if (defensor->tropas <= 0) {
+        // conquista: mudar dono e mover o mínimo de tropas definido pelas regras
+        printf("Território %s foi conquistado por %s!\n", defensor->nome, jogo->nomesJogadores[atacante->dono]);
+        int mover = conquistarTerritorio(jogo, idxAtacante, idxDefensor, regras->minimoConquista);
+        printf("%d tropa(s) movida(s) de %s para %s.\n", mover, atacante->nome, defensor->nome);
+    }
+
     printf("\n");
 }
 
-// sortearMissao():
-// Sorteia e retorna um ID de missão aleatório para o jogador.
-// Além disso preenche a descrição e o alvo (quando aplicável).
-// Retorna 0 para tipo 'destruir exército X' e 1 para 'conquistar 3 territórios'.
-int sortearMissao(char *descricao, size_t descSize, char *alvoMissao, size_t alvoSize, const char *corJogador) {
-    // tipos de missões possíveis:
-    // 0 -> Destruir exército <COR_ALVO> (escolhida aleatoriamente, diferente do jogador)
-    // 1 -> Conquistar 3 territórios (ser dono de >= 3 territórios)
-
-    int tipo = rand() % 2;
-    if (tipo == 0) {
-        // escolher uma cor alvo diferente da do jogador
-        const char *possiveis[] = {"Verde", "Azul", "Vermelho", "Amarelo", "Roxo"};
-        size_t n = sizeof(possiveis) / sizeof(possiveis[0]);
-        // escolhe aleatoriamente até que não seja a cor do jogador
-        const char *escolhida = NULL;
-        for (int tent = 0; tent < 10 && escolhida == NULL; ++tent) {
-            const char *c = possiveis[rand() % n];
-            if (strcmp(c, corJogador) != 0) escolhida = c;
-        }
-        if (escolhida == NULL) {
-            // fallback: escolher a primeira que não seja do jogador
-            for (size_t i = 0; i < n; ++i) if (strcmp(possiveis[i], corJogador) != 0) { escolhida = possiveis[i]; break; }
-        }
-        strncpy(alvoMissao, escolhida, alvoSize - 1);
-        alvoMissao[alvoSize - 1] = '\0';
-        snprintf(descricao, descSize, "Destruir o exército %s", alvoMissao);
-    } else {
-        strncpy(alvoMissao, "3Territorios", alvoSize - 1);
-        alvoMissao[alvoSize - 1] = '\0';
-        snprintf(descricao, descSize, "Conquistar 3 territórios");
+// rolarAtaque():
+// Núcleo silencioso de uma rolagem de ataque (usado pela interface e pelos exércitos automáticos):
+// rola os dados com o kernel das regras, aplica as perdas e acumula as estatísticas dos dois jogadores.
+// Os vetores de saída recebem os dados rolados. Não verifica se o ataque é permitido.
+ResultadoRolagem rolarAtaque(Jogo *jogo, size_t idxAtacante, size_t idxDefensor, int *dadosAtaque, int *dadosDefesa) {
+    const Territorio *atacante = &jogo->territorios[idxAtacante];
+    const Territorio *defensor = &jogo->territorios[idxDefensor];
+    ResultadoRolagem r = jogo->regras.kernel(&jogo->rng, atacante->tropas - jogo->regras.guarnicao, defensor->tropas,
+                                             dadosAtaque, dadosDefesa);
+    EstatisticasJogador *ea = &jogo->estatisticas[atacante->dono];
+    EstatisticasJogador *ed = &jogo->estatisticas[defensor->dono];
+    ea->rolagens++;
+    ea->tropasPerdidas += r.perdasAtacante;
+    ea->tropasDestruidas += r.perdasDefensor;
+    ed->tropasPerdidas += r.perdasDefensor;
+    ed->tropasDestruidas += r.perdasAtacante;
+    alterarTropas(jogo, idxAtacante, -r.perdasAtacante);
+    alterarTropas(jogo, idxDefensor, -r.perdasDefensor);
+    return r;
+}
+
+// tropasNaConquista():
+// Quantas tropas realmente ocupam o território conquistado quando o atacante tem 'tropasAtacante' e pede 'mover'.
+static int tropasNaConquista(const Regras *regras, int tropasAtacante, int mover) {
+    if (mover < regras->minimoConquista) mover = regras->minimoConquista;
+    if (mover > tropasAtacante - regras->guarnicao) mover = tropasAtacante - regras->guarnicao;
+    return mover < 1 ? 1 : mover;
+}
+
+// conquistarTerritorio():
+// Passa o território defensor (já sem tropas) para o dono do atacante e move 'mover' tropas para ele, respeitando
+// a guarnição e o mínimo das regras (ao menos 1 tropa ocupa o território; na regra original, se o atacante só
+// tinha 1 tropa, ele fica com 0). Retorna quantas tropas foram movidas.
+int conquistarTerritorio(Jogo *jogo, size_t idxAtacante, size_t idxDefensor, int mover) {
+    const Regras *regras = &jogo->regras;
+    const Territorio *atacante = &jogo->territorios[idxAtacante];
+    const Territorio *defensor = &jogo->territorios[idxDefensor];
+    jogo->estatisticas[atacante->dono].conquistas++;
+    // atualiza o dono para o do atacante (contadores de continente incluídos)
+    transferirTerritorio(jogo, idxDefensor, atacante->dono);
+    mover = tropasNaConquista(regras, atacante->tropas, mover);
+    alterarTropas(jogo, idxAtacante, -mover);
+    alterarTropas(jogo, idxDefensor, mover - defensor->tropas);
+    return mover;
+}
+
+// executarBlitz():
+// Ataca repetidamente, sem saída na tela, até conquistar o defensor ou o atacante ficar só com a guarnição.
+// Numa conquista move todas as tropas do atacante menos uma. Retorna 1 se o território foi conquistado.
+// Quando as duas pilhas cabem na tabela de blitz, a diferença entre o resultado (0 ou 1) e a chance exata
+// vai para a 'sorte' do atacante (e, com sinal trocado, do defensor): uma variável de média zero conhecida,
+// usada como variável de controle pelo simulador.
+int executarBlitz(Jogo *jogo, size_t idxAtacante, size_t idxDefensor) {
+    int dadosAtaque[MAX_DADOS];
+    int dadosDefesa[MAX_DADOS];
+    const Territorio *atacante = &jogo->territorios[idxAtacante];
+    const Territorio *defensor = &jogo->territorios[idxDefensor];
+    EstatisticasJogador *ea = &jogo->estatisticas[atacante->dono];
+    EstatisticasJogador *ed = &jogo->estatisticas[defensor->dono];
+    int exata = atacante->tropas <= MAX_TROPAS_BLITZ && defensor->tropas <= MAX_TROPAS_BLITZ;
+    double chance = exata ? probabilidadeBlitz(&jogo->blitz, atacante->tropas, defensor->tropas) : 0.0;
+    while (atacante->tropas > jogo->regras.guarnicao && defensor->tropas > 0) {
+        rolarAtaque(jogo, idxAtacante, idxDefensor, dadosAtaque, dadosDefesa);
+    }
+    int conquistou = defensor->tropas <= 0;
+    ea->batalhas++;
+    if (exata) {
+        ea->sorte += conquistou - chance;
+        ed->sorte -= conquistou - chance;
     }
-    return tipo;
+    if (!conquistou) return 0;
+    conquistarTerritorio(jogo, idxAtacante, idxDefensor, atacante->tropas - 1);
+    return 1;
 }
 
-// verificarVitoria():
-// Verifica se o jogador cumpriu os requisitos de sua missão atual.
-// Implementa a lógica para cada tipo de missão (destruir um exército ou conquistar um número de territórios).
-// Retorna 1 (verdadeiro) se a missão foi cumprida, e 0 (falso) caso contrário.
-int verificarVitoria(const Territorio *territorios, size_t total, int idMissao, const char *alvoMissao, const char *corJogador) {
-    if (idMissao == 0) {
-        // destruir exército alvo: verificar se ainda existe algum território com exército alvo e tropas > 0
-        for (size_t i = 0; i < total; ++i) {
-            if (strcmp(territorios[i].corExercito, alvoMissao) == 0 && territorios[i].tropas > 0) {
-                return 0; // ainda existe exército alvo
+// transferirTerritorio():
+// Troca o dono de um território e atualiza incrementalmente a posse de continentes, os bônus e as regiões conexas:
+// só o continente do território é tocado (O(1)); o novo dono apenas une o território às regiões vizinhas, e o
+// antigo dono só reconstrói as próprias regiões se o território estava ligado a outros seus (possível divisão).
+// As fronteiras mudam só no território e nos seus vizinhos (O(vizinhos)).
+void transferirTerritorio(Jogo *jogo, size_t idx, int novoDono) {
+    Territorio *t = &jogo->territorios[idx];
+    int antigo = t->dono;
+    if (antigo == novoDono) return;
+    if (jogo->trocasDono != NULL) {
+        jogo->trocasDono[idx]++;
+        jogo->rodadaTroca[idx] = jogo->rodada;
+    }
+
+    const Continente *c = &jogo->continentes[t->continente];
+    int *posse = &jogo->posseContinente[(size_t)t->continente * jogo->totalJogadores];
+    uint64_t bitContinente = UINT64_C(1) << t->continente;
+    if (posse[antigo] == c->totalTerritorios) {
+        jogo->bonusJogador[antigo] -= c->bonus;
+        jogo->continentesJogador[antigo] &= ~bitContinente;
+    }
+    posse[antigo]--;
+    posse[novoDono]++;
+    if (posse[novoDono] == c->totalTerritorios) {
+        jogo->bonusJogador[novoDono] += c->bonus;
+        jogo->continentesJogador[novoDono] |= bitContinente;
+    }
+    jogo->territoriosJogador[antigo]--;
+    jogo->territoriosJogador[novoDono]++;
+    if (t->tropas >= TROPAS_OCUPACAO) {
+        jogo->ocupadosJogador[antigo]--;
+        jogo->ocupadosJogador[novoDono]++;
+    }
+
+    // move o território da lista do antigo dono para a do novo
+    int i = (int)idx;
+    if (jogo->anteriorDoJogador[i] >= 0) jogo->proximoDoJogador[jogo->anteriorDoJogador[i]] = jogo->proximoDoJogador[i];
+    else jogo->primeiroDoJogador[antigo] = jogo->proximoDoJogador[i];
+    if (jogo->proximoDoJogador[i] >= 0) jogo->anteriorDoJogador[jogo->proximoDoJogador[i]] = jogo->anteriorDoJogador[i];
+    jogo->anteriorDoJogador[i] = -1;
+    jogo->proximoDoJogador[i] = jogo->primeiroDoJogador[novoDono];
+    if (jogo->primeiroDoJogador[novoDono] >= 0) jogo->anteriorDoJogador[jogo->primeiroDoJogador[novoDono]] = i;
+    jogo->primeiroDoJogador[novoDono] = i;
+
+    // o território estava ligado a outros do antigo dono? então a região dele pode ter se dividido
+    int ligadoAoAntigo = 0;
+    for (size_t v = jogo->inicioVizinhos[idx]; v < jogo->inicioVizinhos[idx + 1]; ++v) {
+        if (jogo->territorios[jogo->vizinhos[v]].dono == antigo) { ligadoAoAntigo = 1; break; }
+    }
+
+    if (jogo->inimigosVizinhos[idx] > 0) removerDaFronteira(jogo, idx);
+    t->dono = novoDono;
+    atualizarFronteira(jogo, idx, antigo);
+    invalidarAmeaca(jogo, idx);
+
+    if (ligadoAoAntigo) reconstruirRegioes(jogo, antigo);
+    // para o novo dono, o território começa como região própria e se une às regiões vizinhas
+    jogo->paiRegiao[idx] = i;
+    jogo->rankRegiao[idx] = 0;
+    for (size_t v = jogo->inicioVizinhos[idx]; v < jogo->inicioVizinhos[idx + 1]; ++v) {
+        if (jogo->territorios[jogo->vizinhos[v]].dono == novoDono) unirRegioes(jogo, idx, (size_t)jogo->vizinhos[v]);
+    }
+
+    // exército eliminado por outro jogador: quem tinha a missão de destruí-lo passa para a missão alternativa
+    // (evento raro, então a recompilação não pesa no custo por batalha)
+    if (jogo->territoriosJogador[antigo] == 0) {
+        jogo->estatisticas[antigo].eliminadoNaRodada = jogo->rodada;
+        for (int j = 0; j < jogo->totalJogadores; ++j) {
+            const MissaoCompilada *m = &jogo->missoes[j];
+            if (j != novoDono && m->id >= 0 && jogo->catalogo[m->id].tipo == MISSAO_DESTRUIR &&
+                jogo->catalogo[m->id].alvo == antigo) {
+                compilarMissao(jogo, m->id, j, &jogo->missoes[j]);
             }
         }
-        return 1; // não existe mais exército alvo => missão cumprida
-    } else if (idMissao == 1) {
-        // conquistar 3 territórios: contar quantos territórios são do jogador
-        int contador = 0;
-        for (size_t i = 0; i < total; ++i) {
-            if (strcmp(territorios[i].corExercito, corJogador) == 0) contador++;
-        }
-        return (contador >= 3) ? 1 : 0;
+    }
+}
+
+// alterarTropas():
+// Soma 'delta' às tropas de um território mantendo o contador de territórios ocupados do dono
+// (e marcando as ameaças do território e dos vizinhos para recálculo).
+// Toda mudança de tropas passa por aqui para que as missões continuem verificáveis em tempo constante.
+void alterarTropas(Jogo *jogo, size_t idx, int delta) {
+    Territorio *t = &jogo->territorios[idx];
+    int antes = t->tropas >= TROPAS_OCUPACAO;
+    t->tropas += delta;
+    jogo->ocupadosJogador[t->dono] += (t->tropas >= TROPAS_OCUPACAO) - antes;
+    invalidarAmeaca(jogo, idx);
+}
+
+// faseDeFortificacao():
+// Interface do remanejamento: o jogador escolhe origem, destino e quantidade de tropas a mover
+// entre territórios próprios conectados por territórios próprios. Retorna 1 se o movimento foi feito.
+int faseDeFortificacao(Jogo *jogo, int jogador) {
+    int quantidade = 0;
+    printf("Território de origem (1 - %zu ou nome): ", jogo->total);
+    int origem = lerTerritorio(jogo);
+    if (origem == FIM_ENTRADA) return 0;
+    if (origem < 0) { printf("Território não encontrado.\n"); return 0; }
+    printf("Território de destino (1 - %zu ou nome): ", jogo->total);
+    int destino = lerTerritorio(jogo);
+    if (destino == FIM_ENTRADA) return 0;
+    if (destino < 0) { printf("Território não encontrado.\n"); return 0; }
+    printf("Quantas tropas mover: ");
+    int lidos = lerInteiro(&quantidade);
+    if (lidos == FIM_ENTRADA) return 0;
+    if (!lidos) { printf("Entrada inválida.\n"); return 0; }
+
+    if (jogo->territorios[origem].dono != jogador) {
+        printf("Escolha um território de origem seu.\n");
+        return 0;
+    }
+    if (!moverTropas(jogo, (size_t)origem, (size_t)destino, quantidade)) {
+        printf("Movimento inválido: os territórios precisam ser seus, conectados, e a origem deve manter ao menos 1 tropa.\n");
+        return 0;
+    }
+    printf("%d tropa(s) movida(s) de %s para %s.\n", quantidade, jogo->territorios[origem].nome, jogo->territorios[destino].nome);
+    return 1;
+}
+
+// moverTropas():
+// Move tropas entre dois territórios do mesmo dono que estejam na mesma região conexa,
+// mantendo ao menos 1 tropa na origem. A conectividade é respondida pela união-busca, sem busca no grafo.
+// Retorna 1 se o movimento foi feito ou 0 se for inválido.
+int moverTropas(Jogo *jogo, size_t origem, size_t destino, int quantidade) {
+    if (origem == destino || quantidade < 1) return 0;
+    if (!mesmaRegiao(jogo, origem, destino)) return 0;
+    if (jogo->territorios[origem].tropas - quantidade < 1) return 0;
+    alterarTropas(jogo, origem, -quantidade);
+    alterarTropas(jogo, destino, quantidade);
+    return 1;
+}
+
+// compararNomes():
+// Compara dois nomes de território sem diferenciar maiúsculas de minúsculas (ASCII) e tratando '_' como espaço,
+// para que "mata_atlantica" encontre "Mata Atlantica".
+static int compararNomes(const char *a, const char *b) {
+    for (;; ++a, ++b) {
+        unsigned char ca = (unsigned char)*a, cb = (unsigned char)*b;
+        if (ca == '_') ca = ' ';
+        if (cb == '_') cb = ' ';
+        if (ca >= 'A' && ca <= 'Z') ca = (unsigned char)(ca - 'A' + 'a');
+        if (cb >= 'A' && cb <= 'Z') cb = (unsigned char)(cb - 'A' + 'a');
+        if (ca != cb || ca == '\0') return (int)ca - (int)cb;
+    }
+}
+
+// compararEntradasNome():
+// Comparação de EntradaNome para qsort()/bsearch().
+static int compararEntradasNome(const void *a, const void *b) {
+    return compararNomes(((const EntradaNome *)a)->nome, ((const EntradaNome *)b)->nome);
+}
+
+// compararIndices():
+// Comparação de inteiros em ordem crescente para qsort().
+static int compararIndices(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// montarIndiceNomes():
+// Ordena os territórios pelo nome uma única vez, quando o mapa é carregado (os nomes não mudam durante a partida).
+// Retorna 0 se faltar memória.
+int montarIndiceNomes(Jogo *jogo) {
+    jogo->indiceNomes = (EntradaNome *)alocarArena(&jogo->memoria, jogo->total, sizeof(EntradaNome));
+    if (jogo->indiceNomes == NULL) return 0;
+    for (size_t i = 0; i < jogo->total; ++i) {
+        jogo->indiceNomes[i].nome = jogo->territorios[i].nome;
+        jogo->indiceNomes[i].territorio = (int)i;
+    }
+    qsort(jogo->indiceNomes, jogo->total, sizeof(EntradaNome), compararEntradasNome);
+    return 1;
+}
+
+// buscarTerritorio():
+// Retorna o índice (a partir de 0) do território com o nome dado, por busca binária no índice de nomes
+// (O(log n) comparações), ou -1 se não existir.
+int buscarTerritorio(const Jogo *jogo, const char *nome) {
+    EntradaNome chave = {nome, -1};
+    const EntradaNome *e = (const EntradaNome *)bsearch(&chave, jogo->indiceNomes, jogo->total, sizeof(EntradaNome),
+                                                         compararEntradasNome);
+    return e != NULL ? e->territorio : -1;
+}
+
+// saoVizinhos():
+// Retorna 1 se os dois territórios fazem fronteira.
+int saoVizinhos(const Jogo *jogo, size_t a, size_t b) {
+    for (size_t v = jogo->inicioVizinhos[a]; v < jogo->inicioVizinhos[a + 1]; ++v) {
+        if ((size_t)jogo->vizinhos[v] == b) return 1;
     }
     return 0;
 }
 
-// limparBufferEntrada():
-// Função utilitária para limpar o buffer de entrada do teclado (stdin), evitando problemas com leituras consecutivas de scanf e getchar.
-void limparBufferEntrada(void) {
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF) { /* descarta */ }
+// encontrarRegiao():
+// Retorna o representante da região conexa do território. A união por rank mantém as árvores com
+// altura logarítmica, então a consulta não precisa modificar a estrutura (e pode receber 'const').
+int encontrarRegiao(const Jogo *jogo, size_t idx) {
+    int r = (int)idx;
+    while (jogo->paiRegiao[r] != r) r = jogo->paiRegiao[r];
+    return r;
 }
 
-// indiceCorParaANSI():
-// Retorna o índice do array coresANSI para uma cor conhecida (ou -1 caso não encontre).
-int indiceCorParaANSI(const char *cor) {
-    if (strcmp(cor, "Verde") == 0) return 0;
-    if (strcmp(cor, "Azul") == 0) return 1;
-    if (strcmp(cor, "Vermelho") == 0) return 2;
-    if (strcmp(cor, "Amarelo") == 0) return 3;
-    if (strcmp(cor, "Roxo") == 0) return 4;
-    return -1;
-}
\ No newline at end of file
+// mesmaRegiao():
+// Retorna 1 se os dois territórios são do mesmo dono e estão ligados por territórios desse dono.
+int mesmaRegiao(const Jogo *jogo, size_t a, size_t b) {
+    return jogo->territorios[a].dono == jogo->territorios[b].dono && encontrarRegiao(jogo, a) == encontrarRegiao(jogo, b);
+}
+
+// unirRegioes():
+// Une as regiões de dois territórios (união por rank, com compressão de caminho nas atualizações).
+void unirRegioes(Jogo *jogo, size_t a, size_t b) {
+    int ra = encontrarRegiao(jogo, a), rb = encontrarRegiao(jogo, b);
+    // compressão: os dois territórios passam a apontar direto para a raiz
+    jogo->paiRegiao[a] = ra;
+    jogo->paiRegiao[b] = rb;
+    if (ra == rb) return;
+    if (jogo->rankRegiao[ra] < jogo->rankRegiao[rb]) { int tmp = ra; ra = rb; rb = tmp; }
+    jogo->paiRegiao[rb] = ra;
+    if (jogo->rankRegiao[ra] == jogo->rankRegiao[rb]) jogo->rankRegiao[ra]++;
+}
+
+// reconstruirRegioes():
+// Refaz do zero as regiões conexas de um único jogador, percorrendo apenas os territórios dele.
+// Usada quando o jogador perde um território que podia estar ligando partes de uma região.
+void reconstruirRegioes(Jogo *jogo, int jogador) {
+    for (int t = jogo->primeiroDoJogador[jogador]; t >= 0; t = jogo->proximoDoJogador[t]) {
+        jogo->paiRegiao[t] = t;
+        jogo->rankRegiao[t] = 0;
+    }
+    for (int t = jogo->primeiroDoJogador[jogador]; t >= 0; t = jogo->proximoDoJogador[t]) {
+        for (size_t v = jogo->inicioVizinhos[t]; v < jogo->inicioVizinhos[t + 1]; ++v) {
+            int u = jogo->vizinhos[v];
+            if (u > t && jogo->territorios[u].dono == jogador) unirRegioes(jogo, (size_t)t, (size_t)u);
+        }
+    }
+}
+
+// inserirNaFronteira():
+// Coloca o território no início da lista de fronteira do seu dono atual.
+void inserirNaFronteira(Jogo *jogo, size_t idx) {
+    int dono = jogo->territorios[idx].dono, i = (int)idx;
+    jogo->anteriorNaFronteira[i] = -1;
+    jogo->proximoNaFronteira[i] = jogo->primeiroNaFronteira[dono];
+    if (jogo->primeiroNaFronteira[dono] >= 0) jogo->anteriorNaFronteira[jogo->primeiroNaFronteira[dono]] = i;
+    jogo->primeiroNaFronteira[dono] = i;
+    jogo->tamanhoFronteira[dono]++;
+}
+
+// removerDaFronteira():
+// Tira o território da lista de fronteira do seu dono atual (precisa estar nela).
+void removerDaFronteira(Jogo *jogo, size_t idx) {
+    int dono = jogo->territorios[idx].dono, i = (int)idx;
+    if (jogo->anteriorNaFronteira[i] >= 0) jogo->proximoNaFronteira[jogo->anteriorNaFronteira[i]] = jogo->proximoNaFronteira[i];
+    else jogo->primeiroNaFronteira[dono] = jogo->proximoNaFronteira[i];
+    if (jogo->proximoNaFronteira[i] >= 0) jogo->anteriorNaFronteira[jogo->proximoNaFronteira[i]] = jogo->anteriorNaFronteira[i];
+    jogo->tamanhoFronteira[dono]--;
+}
+
+// atualizarFronteira():
+// Chamada logo depois de o território 'idx' passar de 'antigo' para o dono atual (já fora da fronteira de 'antigo'):
+// recontam-se os inimigos do território e cada vizinho ganha ou perde um inimigo conforme o dono dele;
+// só quem cruza o zero entra ou sai da lista de fronteira do próprio dono.
+void atualizarFronteira(Jogo *jogo, size_t idx, int antigo) {
+    int novo = jogo->territorios[idx].dono;
+    int inimigos = 0;
+    for (size_t v = jogo->inicioVizinhos[idx]; v < jogo->inicioVizinhos[idx + 1]; ++v) {
+        size_t u = (size_t)jogo->vizinhos[v];
+        int donoVizinho = jogo->territorios[u].dono;
+        inimigos += donoVizinho != novo;
+        int delta = (donoVizinho != novo) - (donoVizinho != antigo);
+        if (delta == 0) continue;
+        int antes = jogo->inimigosVizinhos[u] > 0;
+        jogo->inimigosVizinhos[u] += delta;
+        int depois = jogo->inimigosVizinhos[u] > 0;
+        if (antes && !depois) removerDaFronteira(jogo, u);
+        else if (!antes && depois) inserirNaFronteira(jogo, u);
+    }
+    jogo->inimigosVizinhos[idx] = inimigos;
+    if (inimigos > 0) inserirNaFronteira(jogo, idx);
+}
+
+// calcularReforcos():
+// Tropas recebidas no início do turno: metade dos territórios (mínimo REFORCO_MINIMO) mais os bônus de continente.
+// Usa apenas contadores mantidos incrementalmente, então custa O(1).
+int calcularReforcos(const Jogo *jogo, int jogador) {
+    int porTerritorios = jogo->territoriosJogador[jogador] / 2;
+    if (porTerritorios < REFORCO_MINIMO) porTerritorios = REFORCO_MINIMO;
+    return porTerritorios + jogo->bonusJogador[jogador];
+}
+
+// faseDeReforco():
+// Interface da fase de reforço: informa quantas tropas o jogador recebe e pede onde colocá-las.
+// O jogador pode distribuir manualmente ou deixar o otimizador (o mesmo usado pelos oponentes) decidir.
+// Retorna 0 se a entrada acabar antes de todas as tropas serem posicionadas.
+int faseDeReforco(Jogo *jogo, int jogador) {
+    if (jogo->territoriosJogador[jogador] == 0) return 1;
+    int restantes = calcularReforcos(jogo, jogador);
+    printf("=== Fase de Reforço ===\n");
+    printf("Você recebe %d tropa(s) (%d de bônus de continentes).\n", restantes, jogo->bonusJogador[jogador]);
+
+    while (restantes > 0) {
+        int idx = 0, quantidade = 0;
+        printf("Território para reforçar (1 - %zu, 0 = distribuição automática), restam %d: ", jogo->total, restantes);
+        int lidos = lerInteiro(&idx);
+        if (lidos == FIM_ENTRADA) return 0;
+        if (!lidos) { printf("Entrada inválida.\n"); continue; }
+
+        if (idx == 0) {
+            int *alocacao = (int *)alocarArena(jogo->rascunho, jogo->total, sizeof(int));
+            if (alocacao == NULL) { printf("Sem memória para o otimizador. Distribua manualmente.\n"); continue; }
+            otimizarReforco(jogo, jogador, restantes, alocacao);
+            for (size_t i = 0; i < jogo->total; ++i) {
+                if (alocacao[i] > 0) {
+                    alterarTropas(jogo, i, alocacao[i]);
+                    printf("  +%d em %s\n", alocacao[i], jogo->territorios[i].nome);
+                }
+            }
+            restantes = 0;
+            break;
+        }
+        if (idx < 1 || idx > (int)jogo->total || jogo->territorios[idx - 1].dono != jogador) {
+            printf("Escolha um território seu.\n");
+            continue;
+        }
+        printf("Quantas tropas (1 - %d): ", restantes);
+        lidos = lerInteiro(&quantidade);
+        if (lidos == FIM_ENTRADA) return 0;
+        if (!lidos) { printf("Entrada inválida.\n"); continue; }
+        if (quantidade < 1 || quantidade > restantes) {
+            printf("Quantidade inválida.\n");
+            continue;
+        }
+        alterarTropas(jogo, (size_t)(idx - 1), quantidade);
+        restantes -= quantidade;
+    }
+    printf("\n");
+    return 1;
+}
+
+// reforcarOponentes():
+// Ao fim do turno do jogador, cada exército adversário ainda vivo recebe e posiciona seus reforços pelo otimizador.
+void reforcarOponentes(Jogo *jogo, int jogadorHumano) {
+    int *alocacao = (int *)alocarArena(jogo->rascunho, jogo->total, sizeof(int));
+    if (alocacao == NULL) return;
+    for (int j = 0; j < jogo->totalJogadores; ++j) {
+        if (j == jogadorHumano || jogo->territoriosJogador[j] == 0) continue;
+        memset(alocacao, 0, jogo->total * sizeof(int));
+        int tropas = calcularReforcos(jogo, j);
+        otimizarReforco(jogo, j, tropas, alocacao);
+        for (size_t i = 0; i < jogo->total; ++i) {
+            if (alocacao[i] > 0) alterarTropas(jogo, i, alocacao[i]);
+        }
+        printf("Exército %s recebeu %d tropa(s) de reforço.\n", jogo->nomesJogadores[j], tropas);
+    }
+}
+
+// Contexto compartilhado pelas avaliações paralelas do otimizador de reforço.
+// A pontuação da posição é a soma dos termos de defesa da fronteira (os do interior são constantes) mais o melhor
+// termo de ataque;
+// colocar tropas em um território só muda os termos dele, então cada candidato é avaliado em O(vizinhos)
+// a partir dos termos atuais (defesa[k], ataque[k]) e dos dois maiores ataques.
+typedef struct {
+    const Jogo *jogo;
+    int jogador;
+    const int *alocacao;   // reforços já decididos (indexado por território)
+    const int *proprios;   // territórios da fronteira do jogador
+    const double *defesa;  // termo de defesa atual de cada território da fronteira (mesma ordem de 'proprios')
+    const double *ataque;  // melhor ataque atual a partir de cada território da fronteira
+    double defesaTotal;
+    double melhorAtaque;
+    double segundoAtaque;
+    size_t posMelhorAtaque;
+    int lote;              // tropas colocadas no candidato avaliado
+    double *pontuacao;     // saída: pontuação de colocar o lote em cada território da fronteira
+} ContextoReforco;
+
+// valorTerritorio():
+// Peso estratégico de um território: 1 mais sua fração do bônus do continente.
+static double valorTerritorio(const Jogo *jogo, size_t idx) {
+    const Continente *c = &jogo->continentes[jogo->territorios[idx].continente];
+    return 1.0 + (double)c->bonus / (double)c->totalTerritorios;
+}
+
+// avaliarTerritorio():
+// Termos da pontuação de um território próprio com 'minhas' tropas: a chance de resistir ao vizinho inimigo
+// mais forte (defesa, ponderada pelo valor do território) e a melhor chance ponderada de conquistar um
+// território inimigo vizinho (ataque). Todas as probabilidades vêm de consultas O(1) à tabela de blitz.
+static void avaliarTerritorio(const Jogo *jogo, int jogador, size_t t, int minhas, double *defesa, double *ataque) {
+    double pior = 0.0, melhor = 0.0;
+    for (size_t v = jogo->inicioVizinhos[t]; v < jogo->inicioVizinhos[t + 1]; ++v) {
+        size_t e = (size_t)jogo->vizinhos[v];
+        if (jogo->territorios[e].dono == jogador) continue;
+        int deles = jogo->territorios[e].tropas;
+        double perda = probabilidadeBlitz(&jogo->blitz, deles, minhas);
+        if (perda > pior) pior = perda;
+        double ganho = probabilidadeBlitz(&jogo->blitz, minhas, deles) * valorTerritorio(jogo, e);
+        if (ganho > melhor) melhor = ganho;
+    }
+    *defesa = (1.0 - pior) * valorTerritorio(jogo, t);
+    *ataque = melhor;
+}
+
+// avaliarCandidatoReforco():
+// Tarefa paralela: pontua a colocação do lote atual no território da fronteira de posição 'indice'.
+static void avaliarCandidatoReforco(void *contexto, size_t indice) {
+    ContextoReforco *ctx = (ContextoReforco *)contexto;
+    size_t t = (size_t)ctx->proprios[indice];
+    int minhas = ctx->jogo->territorios[t].tropas + ctx->alocacao[t] + ctx->lote;
+    double defesa, ataque;
+    avaliarTerritorio(ctx->jogo, ctx->jogador, t, minhas, &defesa, &ataque);
+    double outros = indice == ctx->posMelhorAtaque ? ctx->segundoAtaque : ctx->melhorAtaque;
+    ctx->pontuacao[indice] = ctx->defesaTotal - ctx->defesa[indice] + defesa + (ataque > outros ? ataque : outros);
+}
+
+// otimizarReforco():
+// Decide onde o jogador deve colocar 'tropas' reforços e soma a quantidade por território em 'alocacao'.
+// Distribui as tropas em lotes: a cada passo, todas as alocações candidatas (lote em cada território da fronteira)
+// são avaliadas em paralelo com consultas à tabela de blitz, e o melhor candidato é fixado (empates ficam com
+// o menor índice). Territórios do interior não mudam a pontuação, então só a fronteira do jogador é percorrida;
+// sem fronteira, tudo vai para o território próprio de menor índice. Os vetores de trabalho saem do rascunho do turno.
+void otimizarReforco(const Jogo *jogo, int jogador, int tropas, int *alocacao) {
+    if (jogo->territoriosJogador[jogador] == 0) return;
+    size_t n = (size_t)jogo->tamanhoFronteira[jogador];
+    if (n == 0) {
+        int menor = jogo->primeiroDoJogador[jogador];
+        for (int t = menor; t >= 0; t = jogo->proximoDoJogador[t]) if (t < menor) menor = t;
+        alocacao[menor] += tropas;
+        return;
+    }
+    int *proprios = (int *)alocarArena(jogo->rascunho, n, sizeof(int));
+    double *defesa = (double *)alocarArena(jogo->rascunho, n, sizeof(double));
+    double *ataque = (double *)alocarArena(jogo->rascunho, n, sizeof(double));
+    double *pontuacao = (double *)alocarArena(jogo->rascunho, n, sizeof(double));
+    if (proprios == NULL || defesa == NULL || ataque == NULL || pontuacao == NULL) {
+        // sem memória: tudo no primeiro território da fronteira
+        alocacao[jogo->primeiroNaFronteira[jogador]] += tropas;
+        return;
+    }
+    size_t k = 0;
+    for (int t = jogo->primeiroNaFronteira[jogador]; t >= 0; t = jogo->proximoNaFronteira[t]) proprios[k++] = t;
+    // em ordem de índice, para que as somas (e portanto os desempates) não dependam da ordem da lista
+    qsort(proprios, n, sizeof(int), compararIndices);
+
+    ContextoReforco ctx = {jogo, jogador, alocacao, proprios, defesa, ataque, 0.0, 0.0, 0.0, 0, 0, pontuacao};
+    for (size_t i = 0; i < n; ++i) {
+        avaliarTerritorio(jogo, jogador, (size_t)proprios[i], jogo->territorios[proprios[i]].tropas + alocacao[proprios[i]],
+                          &defesa[i], &ataque[i]);
+    }
+
+    // lotes de ~1/8 dos reforços mantêm o número de passos pequeno em turnos com muitas tropas
+    int lote = tropas / 8;
+    if (lote < 1) lote = 1;
+    while (tropas > 0) {
+        ctx.lote = lote < tropas ? lote : tropas;
+        ctx.defesaTotal = ctx.melhorAtaque = ctx.segundoAtaque = 0.0;
+        ctx.posMelhorAtaque = 0;
+        for (size_t i = 0; i < n; ++i) {
+            ctx.defesaTotal += defesa[i];
+            if (ataque[i] > ctx.melhorAtaque) {
+                ctx.segundoAtaque = ctx.melhorAtaque;
+                ctx.melhorAtaque = ataque[i];
+                ctx.posMelhorAtaque = i;
+            } else if (ataque[i] > ctx.segundoAtaque) {
+                ctx.segundoAtaque = ataque[i];
+            }
+        }
+        executarEmParalelo(n, avaliarCandidatoReforco, &ctx);
+        size_t melhor = 0;
+        for (size_t i = 1; i < n; ++i) {
+            if (pontuacao[i] > pontuacao[melhor] || (pontuacao[i] == pontuacao[melhor] && proprios[i] < proprios[melhor])) {
+                melhor = i;
+            }
+        }
+        size_t t = (size_t)proprios[melhor];
+        alocacao[t] += ctx.lote;
+        tropas -= ctx.lote;
+        avaliarTerritorio(jogo, jogador, t, jogo->territorios[t].tropas + alocacao[t], &defesa[melhor], &ataque[melhor]);
+    }
+}
+
+// calcularTabelaBlitz():
+// Preenche a tabela de blitz para as regras dadas. Primeiro enumera todas as rolagens possíveis
+// (no máximo 6^6) para obter a distribuição de perdas de cada combinação de dados; depois resolve
+// a programação dinâmica vitoria[a][d] = soma_k p_k * vitoria[a - perdasAtaque_k][d - perdasDefesa_k].
+// Rolagens sem perda para ninguém (regra original) são laços e entram como renormalização.
+// Retorna 0 se faltar memória.
+int calcularTabelaBlitz(TabelaBlitz *tabela, const Regras *regras) {
+    const int lado = MAX_TROPAS_BLITZ + 1;
+    tabela->vitoria = (double *)calloc((size_t)lado * lado, sizeof(double));
+    if (tabela->vitoria == NULL) return 0;
+
+    memset(tabela->probRolagem, 0, sizeof(tabela->probRolagem));
+    for (int nA = 1; nA <= MAX_DADOS; ++nA) {
+        for (int nD = 1; nD <= MAX_DADOS; ++nD) {
+            int combinacoes = 1;
+            for (int i = 0; i < nA + nD; ++i) combinacoes *= 6;
+            for (int c = 0; c < combinacoes; ++c) {
+                int dados[2 * MAX_DADOS] = {0};
+                int resto = c;
+                for (int i = 0; i < nA + nD; ++i) { dados[i] = resto % 6 + 1; resto /= 6; }
+                int ataque[MAX_DADOS] = {0}, defesa[MAX_DADOS] = {0};
+                for (int i = 0; i < nA; ++i) ataque[i] = dados[i];
+                for (int i = 0; i < nD; ++i) defesa[i] = dados[nA + i];
+                ResultadoRolagem r = compararDados(ataque, defesa, nA, nD, regras);
+                tabela->probRolagem[nA - 1][nD - 1][r.perdasDefensor] += 1.0 / combinacoes;
+            }
+        }
+    }
+
+    for (int a = 0; a < lado; ++a) {
+        for (int d = 0; d < lado; ++d) {
+            double *p = &tabela->vitoria[a * lado + d];
+            if (d == 0) { *p = 1.0; continue; }
+            if (a <= regras->guarnicao) { *p = 0.0; continue; }
+            int nA = a - regras->guarnicao < regras->dadosAtaque ? a - regras->guarnicao : regras->dadosAtaque;
+            int nD = d < regras->dadosDefesa ? d : regras->dadosDefesa;
+            int pares = nA < nD ? nA : nD;
+            double soma = 0.0, laco = 0.0;
+            for (int k = 0; k <= pares; ++k) {
+                double pk = tabela->probRolagem[nA - 1][nD - 1][k];
+                int perdaAtaque = (pares - k) * regras->atacantePerde;
+                if (k == 0 && perdaAtaque == 0) { laco += pk; continue; }
+                soma += pk * tabela->vitoria[(a - perdaAtaque) * lado + (d - k)];
+            }
+            *p = laco < 1.0 ? soma / (1.0 - laco) : 0.0;
+        }
+    }
+    return 1;
+}
+
+// probabilidadeBlitz():
+// Consulta O(1) da chance de 'tropasAtaque' conquistar 'tropasDefesa'. Pilhas maiores que a tabela são
+// reduzidas proporcionalmente (mesma razão de forças), o que é uma aproximação razoável para pilhas grandes.
+double probabilidadeBlitz(const TabelaBlitz *tabela, int tropasAtaque, int tropasDefesa) {
+    if (tropasDefesa <= 0) return 1.0;
+    if (tropasAtaque <= 0) return 0.0;
+    int maior = tropasAtaque > tropasDefesa ? tropasAtaque : tropasDefesa;
+    if (maior > MAX_TROPAS_BLITZ) {
+        tropasAtaque = (int)((long long)tropasAtaque * MAX_TROPAS_BLITZ / maior);
+        tropasDefesa = (int)((long long)tropasDefesa * MAX_TROPAS_BLITZ / maior);
+        if (tropasDefesa < 1) return 1.0;
+    }
+    return tabela->vitoria[tropasAtaque * (MAX_TROPAS_BLITZ + 1) + tropasDefesa];
+}
+
+// marcarAmeaca():
+// Anota o território para recálculo da ameaça (uma única vez até o próximo atualizarAmeacas()).
+static inline void marcarAmeaca(MapaAmeacas *m, size_t idx) {
+    if (m->sujo[idx]) return;
+    m->sujo[idx] = 1;
+    m->pendentes[m->totalPendentes++] = (int)idx;
+}
+
+// invalidarAmeaca():
+// Chamada quando o território muda de tropas ou de dono: a ameaça dele e a de cada vizinho (para quem ele
+// é um possível atacante) deixam de valer. Custa O(vizinhos).
+void invalidarAmeaca(Jogo *jogo, size_t idx) {
+    marcarAmeaca(jogo->ameacas, idx);
+    for (size_t v = jogo->inicioVizinhos[idx]; v < jogo->inicioVizinhos[idx + 1]; ++v) {
+        marcarAmeaca(jogo->ameacas, (size_t)jogo->vizinhos[v]);
+    }
+}
+
+// calcularAmeacaPendente():
+// Tarefa paralela: recalcula a ameaça do território pendente de posição 'indice'. Cada pilha inimiga vizinha
+// que pode atacar faz um blitz independente; o território resiste se resistir a todas (sem contar os reforços
+// dos adversários nem o desgaste entre um ataque e outro), então a ameaça é 1 - produto(1 - P_blitz).
+static void calcularAmeacaPendente(void *contexto, size_t indice) {
+    const Jogo *jogo = (const Jogo *)contexto;
+    size_t t = (size_t)jogo->ameacas->pendentes[indice];
+    const Territorio *alvo = &jogo->territorios[t];
+    double resiste = 1.0;
+    for (size_t v = jogo->inicioVizinhos[t]; v < jogo->inicioVizinhos[t + 1]; ++v) {
+        const Territorio *inimigo = &jogo->territorios[jogo->vizinhos[v]];
+        if (inimigo->dono == alvo->dono || inimigo->tropas <= jogo->regras.guarnicao) continue;
+        resiste *= 1.0 - probabilidadeBlitz(&jogo->blitz, inimigo->tropas, alvo->tropas);
+    }
+    jogo->ameacas->probabilidade[t] = 1.0 - resiste;
+    jogo->ameacas->sujo[t] = 0;
+}
+
+// atualizarAmeacas():
+// Recalcula, em paralelo, só as ameaças invalidadas desde a última consulta e retorna o vetor de ameaças
+// (um valor por território, válido até a próxima mudança de tropas ou de dono).
+const double *atualizarAmeacas(const Jogo *jogo) {
+    MapaAmeacas *m = jogo->ameacas;
+    if (m->totalPendentes > 0) {
+        executarEmParalelo(m->totalPendentes, calcularAmeacaPendente, (void *)jogo);
+        m->totalPendentes = 0;
+    }
+    return m->probabilidade;
+}
+
+// Contexto da busca do planejador de ataques, compartilhado pelas subárvores avaliadas em paralelo.
+// A busca só conquista territórios que contam para a missão ('objetivo'), então todo plano completo tem
+// exatamente 'passos' ataques. Um plano é uma sequência de cadeias: cada cadeia parte de um território
+// próprio (em 'origens', em ordem crescente de índice, para não repetir permutações de cadeias independentes)
+// e segue atacando a partir da última conquista, que recebeu as tropas. Cadeias diferentes são independentes,
+// então a chance do plano é o produto das chances das cadeias.
+typedef struct {
+    const Jogo *jogo;
+    int jogador;
+    int passos;
+    const unsigned char *objetivo;
+    const int *origens;
+    size_t totalOrigens;
+    int raizOrigem[LARGURA_PLANO]; // primeiro ataque de cada subárvore
+    int raizDestino[LARGURA_PLANO];
+    size_t raizPosicao[LARGURA_PLANO];
+    double raizChance[LARGURA_PLANO];
+    double limitePasso;            // maior chance possível de um único ataque (para a poda)
+    double limiteInicial;          // melhor chance da primeira subárvore (buscada antes das outras), cota fixa de poda
+    PlanoAtaque resultados[LARGURA_PLANO];
+    struct BuscaPlano *buscas;     // estado de busca de cada subárvore (no rascunho do turno)
+    unsigned char *tomados;        // 'tomado' de cada subárvore, 'total' bytes cada
+} ContextoPlano;
+
+// Estado de busca de uma subárvore (uma por tarefa paralela).
+// distribuicao[n][a] é a probabilidade de a cadeia atual ter chegado ao passo 'n' com 'a' tropas no território
+// conquistado; a massa total da linha é a chance de a cadeia ter dado certo até ali.
+typedef struct BuscaPlano {
+    unsigned char *tomado; // tomado[t] = 1 se 't' já é conquistado pelo plano parcial
+    double distribuicao[MAX_PASSOS_PLANO + 1][MAX_TROPAS_BLITZ + 1];
+    double inicial[MAX_TROPAS_BLITZ + 1];  // pilha fixa da origem de uma cadeia nova
+    double massa[(MAX_TROPAS_BLITZ + 1) * (MAX_TROPAS_BLITZ + 1)];
+    long nos;
+    PlanoAtaque atual;
+    PlanoAtaque melhor;
+} BuscaPlano;
+
+// Candidato a próximo ataque dentro da busca.
+typedef struct {
+    int origem;
+    int destino;
+    size_t posicao;  // posição da origem em 'origens' (cadeia nova) ou SIZE_MAX (continua a cadeia atual)
+    double chance;   // chance do plano parcial depois deste ataque
+} CandidatoPlano;
+
+// distribuicaoBlitz():
+// Propaga a distribuição 'entrada' das tropas do atacante por uma blitz contra 'defesa' tropas (programação
+// dinâmica para frente sobre os estados (atacante, defensor), com os mesmos laços renormalizados da tabela de
+// blitz) e escreve em 'saida' a distribuição das tropas que ocupam o território conquistado. Pilhas maiores
+// que MAX_TROPAS_BLITZ são truncadas. Retorna a chance de conquista (massa de 'saida').
+static double distribuicaoBlitz(const Jogo *jogo, const double *entrada, int defesa, double *saida, double *massa) {
+    const Regras *regras = &jogo->regras;
+    if (defesa > MAX_TROPAS_BLITZ) defesa = MAX_TROPAS_BLITZ;
+    const int colunas = defesa + 1;
+    memset(saida, 0, (MAX_TROPAS_BLITZ + 1) * sizeof(double));
+    int lado = MAX_TROPAS_BLITZ + 1; // só as linhas até a maior pilha possível do atacante
+    while (lado > 0 && entrada[lado - 1] == 0.0) --lado;
+    memset(massa, 0, (size_t)lado * (size_t)colunas * sizeof(double));
+    for (int a = 0; a < lado; ++a) massa[a * colunas + defesa] = entrada[a];
+
+    // estados em ordem de defesa decrescente e, na mesma defesa, de ataque decrescente: toda rolagem que
+    // custa tropas leva a um estado ainda não processado
+    double vitoria = 0.0;
+    for (int d = defesa; d >= 0; --d) {
+        for (int a = lado - 1; a > regras->guarnicao; --a) {
+            double m = massa[a * colunas + d];
+            if (m == 0.0) continue;
+            if (d == 0) {
+                saida[tropasNaConquista(regras, a, a - 1)] += m;
+                vitoria += m;
+                continue;
+            }
+            int nA = a - regras->guarnicao < regras->dadosAtaque ? a - regras->guarnicao : regras->dadosAtaque;
+            int nD = d < regras->dadosDefesa ? d : regras->dadosDefesa;
+            int pares = nA < nD ? nA : nD;
+            const double *pk = jogo->blitz.probRolagem[nA - 1][nD - 1];
+            double laco = regras->atacantePerde ? 0.0 : pk[0];
+            if (laco >= 1.0) continue;
+            double escala = m / (1.0 - laco);
+            for (int k = 0; k <= pares; ++k) {
+                int perdaAtaque = (pares - k) * regras->atacantePerde;
+                if (k == 0 && perdaAtaque == 0) continue;
+                massa[(a - perdaAtaque) * colunas + (d - k)] += pk[k] * escala;
+            }
+        }
+    }
+    return vitoria;
+}
+
+// chanceTruncada():
+// Chance de blitz com as pilhas truncadas em MAX_TROPAS_BLITZ, coerente com distribuicaoBlitz().
+static double chanceTruncada(const Jogo *jogo, int tropasAtaque, int tropasDefesa) {
+    if (tropasAtaque > MAX_TROPAS_BLITZ) tropasAtaque = MAX_TROPAS_BLITZ;
+    if (tropasDefesa > MAX_TROPAS_BLITZ) tropasDefesa = MAX_TROPAS_BLITZ;
+    return jogo->blitz.vitoria[tropasAtaque * (MAX_TROPAS_BLITZ + 1) + tropasDefesa];
+}
+
+// limiarPoda():
+// Chance abaixo da qual um ramo é podado: a melhor entre a da primeira subárvore e a da própria subárvore.
+// Nada vem de subárvores que rodam ao mesmo tempo, então o plano não depende da ordem de execução das
+// tarefas nem da quantidade de threads.
+static double limiarPoda(const ContextoPlano *ctx, const BuscaPlano *b) {
+    return b->melhor.probabilidade > ctx->limiteInicial ? b->melhor.probabilidade : ctx->limiteInicial;
+}
+
+// inserirCandidato():
+// Mantém os LARGURA_PLANO melhores candidatos do nível em ordem decrescente de chance (empates na ordem de geração).
+static void inserirCandidato(CandidatoPlano *lista, int *total, CandidatoPlano c) {
+    int i = *total < LARGURA_PLANO ? (*total)++ : LARGURA_PLANO;
+    while (i > 0 && lista[i - 1].chance < c.chance) {
+        if (i < LARGURA_PLANO) lista[i] = lista[i - 1];
+        --i;
+    }
+    if (i < LARGURA_PLANO) lista[i] = c;
+}
+
+// chanceLimite():
+// Cota superior da chance final a partir de 'chance' com 'restantes' ataques ainda por fazer.
+static double chanceLimite(const ContextoPlano *ctx, double chance, int restantes) {
+    while (restantes-- > 0) chance *= ctx->limitePasso;
+    return chance;
+}
+
+// gerarCandidatos():
+// Lista os melhores próximos ataques do nível 'nivel': continuar a cadeia atual a partir da última conquista
+// (chance exata pela distribuição de tropas) ou fechá-la e abrir uma cadeia nova num território próprio de
+// posição maior que 'posicao' (chance O(1) pela tabela de blitz). Descarta candidatos que a poda já elimina.
+static int gerarCandidatos(ContextoPlano *ctx, BuscaPlano *b, int nivel, size_t posicao, double fechado,
+                           CandidatoPlano *lista) {
+    const Jogo *jogo = ctx->jogo;
+    const Territorio *territorios = jogo->territorios;
+    double cadeia = 0.0;
+    for (int a = 0; a <= MAX_TROPAS_BLITZ; ++a) cadeia += b->distribuicao[nivel][a];
+    double atual = fechado * cadeia;
+    double melhor = limiarPoda(ctx, b);
+    int restantes = ctx->passos - nivel - 1;
+    int total = 0;
+
+    int cabeca = b->atual.destino[nivel - 1];
+    for (size_t v = jogo->inicioVizinhos[cabeca]; v < jogo->inicioVizinhos[cabeca + 1]; ++v) {
+        int e = jogo->vizinhos[v];
+        if (!ctx->objetivo[e] || b->tomado[e]) continue;
+        double chance = fechado * distribuicaoBlitz(jogo, b->distribuicao[nivel], territorios[e].tropas,
+                                                    b->distribuicao[nivel + 1], b->massa);
+        if (chance > 0.0 && chanceLimite(ctx, chance, restantes) >= melhor) {
+            inserirCandidato(lista, &total, (CandidatoPlano){cabeca, e, SIZE_MAX, chance});
+        }
+    }
+    for (size_t p = posicao + 1; p < ctx->totalOrigens; ++p) {
+        int o = ctx->origens[p];
+        for (size_t v = jogo->inicioVizinhos[o]; v < jogo->inicioVizinhos[o + 1]; ++v) {
+            int e = jogo->vizinhos[v];
+            if (!ctx->objetivo[e] || b->tomado[e]) continue;
+            double chance = atual * chanceTruncada(jogo, territorios[o].tropas, territorios[e].tropas);
+            if (chance > 0.0 && chanceLimite(ctx, chance, restantes) >= melhor) {
+                inserirCandidato(lista, &total, (CandidatoPlano){o, e, p, chance});
+            }
+        }
+    }
+    return total;
+}
+
+// iniciarCadeia():
+// Distribuição da cadeia depois do primeiro ataque a partir do território próprio 'origem'. Retorna sua massa.
+static double iniciarCadeia(const Jogo *jogo, BuscaPlano *b, int nivel, int origem, int destino) {
+    memset(b->inicial, 0, sizeof(b->inicial));
+    int tropas = jogo->territorios[origem].tropas;
+    b->inicial[tropas < MAX_TROPAS_BLITZ ? tropas : MAX_TROPAS_BLITZ] = 1.0;
+    return distribuicaoBlitz(jogo, b->inicial, jogo->territorios[destino].tropas, b->distribuicao[nivel + 1], b->massa);
+}
+
+// concluirPlano():
+// Guarda o plano atual (completo) se for o melhor da subárvore.
+static void concluirPlano(const ContextoPlano *ctx, BuscaPlano *b, double chance) {
+    if (chance <= b->melhor.probabilidade) return;
+    b->melhor = b->atual;
+    b->melhor.total = ctx->passos;
+    b->melhor.probabilidade = chance;
+}
+
+// buscarPlano():
+// Ramificação e poda em profundidade a partir do nível 'nivel' (já com 'nivel' ataques no plano parcial).
+// 'fechado' é o produto das chances das cadeias já encerradas e 'posicao' a origem da cadeia atual.
+static void buscarPlano(ContextoPlano *ctx, BuscaPlano *b, int nivel, size_t posicao, double fechado) {
+    if (++b->nos > NOS_PLANO) return;
+
+    CandidatoPlano lista[LARGURA_PLANO];
+    int total = gerarCandidatos(ctx, b, nivel, posicao, fechado, lista);
+    for (int i = 0; i < total; ++i) {
+        const CandidatoPlano *c = &lista[i];
+        if (chanceLimite(ctx, c->chance, ctx->passos - nivel - 1) < limiarPoda(ctx, b)) break;
+        b->atual.origem[nivel] = c->origem;
+        b->atual.destino[nivel] = c->destino;
+        if (nivel + 1 == ctx->passos) {
+            // último ataque: a chance do candidato já é a do plano completo
+            concluirPlano(ctx, b, c->chance);
+            continue;
+        }
+        b->tomado[c->destino] = 1;
+        if (c->posicao == SIZE_MAX) {
+            distribuicaoBlitz(ctx->jogo, b->distribuicao[nivel], ctx->jogo->territorios[c->destino].tropas,
+                              b->distribuicao[nivel + 1], b->massa);
+            buscarPlano(ctx, b, nivel + 1, posicao, fechado);
+        } else {
+            double cadeia = 0.0;
+            for (int a = 0; a <= MAX_TROPAS_BLITZ; ++a) cadeia += b->distribuicao[nivel][a];
+            iniciarCadeia(ctx->jogo, b, nivel, c->origem, c->destino);
+            buscarPlano(ctx, b, nivel + 1, c->posicao, fechado * cadeia);
+        }
+        b->tomado[c->destino] = 0;
+    }
+}
+
+// buscarSubarvore():
+// Tarefa paralela: explora todos os planos que começam pelo candidato de raiz 'indice'.
+// Cada subárvore tem seu próprio estado (ctx->buscas[indice]), separado antes das tarefas começarem.
+static void buscarSubarvore(void *contexto, size_t indice) {
+    ContextoPlano *ctx = (ContextoPlano *)contexto;
+    BuscaPlano *b = &ctx->buscas[indice];
+    b->tomado = ctx->tomados + indice * ctx->jogo->total;
+    b->atual.origem[0] = ctx->raizOrigem[indice];
+    b->atual.destino[0] = ctx->raizDestino[indice];
+    b->tomado[ctx->raizDestino[indice]] = 1;
+    if (ctx->passos == 1) {
+        concluirPlano(ctx, b, ctx->raizChance[indice]);
+    } else {
+        iniciarCadeia(ctx->jogo, b, 0, ctx->raizOrigem[indice], ctx->raizDestino[indice]);
+        buscarPlano(ctx, b, 1, ctx->raizPosicao[indice], 1.0);
+    }
+    ctx->resultados[indice] = b->melhor;
+}
+
+// buscarSubarvoreSeguinte():
+// Tarefa paralela: buscarSubarvore() para as subárvores depois da primeira.
+static void buscarSubarvoreSeguinte(void *contexto, size_t indice) {
+    buscarSubarvore(contexto, indice + 1);
+}
+
+// planejarAtaques():
+// Procura a sequência de blitz que maximiza a chance de cumprir a missão do jogador ainda neste turno
+// (o que faseDeAtaque() pediria ataque por ataque). Os territórios que contam para a missão saem do predicado
+// compilado: os do alvo (destruir), os inimigos nos continentes da máscara (continentes) ou quaisquer inimigos
+// (N territórios). A busca é ramificação e poda sobre as distribuições de tropas de cada blitz: a chance de um
+// plano parcial só cai a cada ataque, e a cota usa a melhor chance possível de um ataque isolado; cada nível
+// explora os LARGURA_PLANO melhores candidatos; a subárvore do primeiro ataque mais provável é buscada sozinha e
+// sua melhor chance serve de cota para as outras, que rodam em paralelo. Toda a memória da busca sai do rascunho
+// do turno. Missões de ocupação não são planejadas (uma blitz deixa só uma tropa na origem, então não aumenta o
+// número de territórios ocupados), nem missões que exigem mais de MAX_PASSOS_PLANO conquistas. Retorna 1 e
+// preenche 'plano' se a missão já estiver cumprida (plano vazio) ou se algum plano puder cumpri-la; 0 caso contrário.
+int planejarAtaques(const Jogo *jogo, int jogador, PlanoAtaque *plano) {
+    memset(plano, 0, sizeof(*plano));
+    if (verificarVitoria(jogo, jogador)) {
+        plano->probabilidade = 1.0;
+        return 1;
+    }
+    const MissaoCompilada *m = &jogo->missoes[jogador];
+    if (m->minimo > m->maximo || m->contador >= jogo->totalJogadores) return 0;
+
+    unsigned char *objetivo = (unsigned char *)alocarArena(jogo->rascunho, jogo->total, sizeof(unsigned char));
+    int *origens = (int *)alocarArena(jogo->rascunho, (size_t)jogo->tamanhoFronteira[jogador] + 1, sizeof(int));
+    ContextoPlano *ctx = (ContextoPlano *)alocarArena(jogo->rascunho, 1, sizeof(ContextoPlano));
+    if (objetivo == NULL || origens == NULL || ctx == NULL) return 0;
+
+    // territórios que contam para a missão e quantos ataques ela exige
+    int passos = 0, menorDefesa = INT32_MAX, maiorAtaque = 0;
+    for (size_t t = 0; t < jogo->total; ++t) {
+        const Territorio *ter = &jogo->territorios[t];
+        if (ter->dono == jogador) continue;
+        if (m->contador != jogador) objetivo[t] = ter->dono == m->contador;             // destruir
+        else if (m->mascara != 0) objetivo[t] = (m->mascara >> ter->continente) & 1u;   // continentes
+        else objetivo[t] = 1;                                                            // N territórios
+        if (objetivo[t]) {
+            passos++;
+            if (ter->tropas < menorDefesa) menorDefesa = ter->tropas;
+        }
+    }
+    if (m->contador == jogador && m->mascara == 0) passos = m->minimo - jogo->territoriosJogador[jogador];
+
+    // origens possíveis: territórios próprios que podem atacar algum território do objetivo
+    size_t totalOrigens = 0;
+    for (int t = jogo->primeiroNaFronteira[jogador]; t >= 0; t = jogo->proximoNaFronteira[t]) {
+        if (jogo->territorios[t].tropas <= jogo->regras.guarnicao) continue;
+        for (size_t v = jogo->inicioVizinhos[t]; v < jogo->inicioVizinhos[t + 1]; ++v) {
+            if (objetivo[jogo->vizinhos[v]]) {
+                origens[totalOrigens++] = t;
+                if (jogo->territorios[t].tropas > maiorAtaque) maiorAtaque = jogo->territorios[t].tropas;
+                break;
+            }
+        }
+    }
+    qsort(origens, totalOrigens, sizeof(int), compararIndices);
+
+    int encontrou = 0;
+    if (passos >= 1 && passos <= MAX_PASSOS_PLANO && totalOrigens > 0) {
+        ctx->jogo = jogo;
+        ctx->jogador = jogador;
+        ctx->passos = passos;
+        ctx->objetivo = objetivo;
+        ctx->origens = origens;
+        ctx->totalOrigens = totalOrigens;
+        ctx->limitePasso = chanceTruncada(jogo, maiorAtaque, menorDefesa);
+        ctx->limiteInicial = 0.0;
+
+        // primeiro ataque: os melhores candidatos da raiz, cada um uma subárvore independente
+        CandidatoPlano raiz[LARGURA_PLANO];
+        int totalRaiz = 0;
+        for (size_t p = 0; p < totalOrigens; ++p) {
+            int o = origens[p];
+            for (size_t v = jogo->inicioVizinhos[o]; v < jogo->inicioVizinhos[o + 1]; ++v) {
+                int e = jogo->vizinhos[v];
+                if (!objetivo[e]) continue;
+                double chance = chanceTruncada(jogo, jogo->territorios[o].tropas, jogo->territorios[e].tropas);
+                if (chance > 0.0) inserirCandidato(raiz, &totalRaiz, (CandidatoPlano){o, e, p, chance});
+            }
+        }
+        for (int i = 0; i < totalRaiz; ++i) {
+            ctx->raizOrigem[i] = raiz[i].origem;
+            ctx->raizDestino[i] = raiz[i].destino;
+            ctx->raizPosicao[i] = raiz[i].posicao;
+            ctx->raizChance[i] = raiz[i].chance;
+        }
+        ctx->buscas = (BuscaPlano *)alocarArena(jogo->rascunho, (size_t)totalRaiz, sizeof(BuscaPlano));
+        ctx->tomados = (unsigned char *)alocarArena(jogo->rascunho, (size_t)totalRaiz * jogo->total,
+                                                    sizeof(unsigned char));
+        if (ctx->buscas == NULL || ctx->tomados == NULL) totalRaiz = 0;
+        if (totalRaiz > 0) {
+            buscarSubarvore(ctx, 0);
+            ctx->limiteInicial = ctx->resultados[0].probabilidade;
+            executarEmParalelo((size_t)totalRaiz - 1, buscarSubarvoreSeguinte, ctx);
+        }
+
+        // melhor subárvore (empates ficam com o candidato de raiz mais provável)
+        for (int i = 0; i < totalRaiz; ++i) {
+            if (ctx->resultados[i].probabilidade > plano->probabilidade) *plano = ctx->resultados[i];
+        }
+        encontrou = plano->total > 0;
+    }
+    return encontrou;
+}
+
+// reforcarAutomatico():
+// Reforço de um exército automático: calcula os reforços, distribui pelo otimizador e aplica, sem levar nenhum
+// território além de jogo->limiteTropas (o excedente é descartado). Retorna 1 se o teto descartou alguma tropa.
+static int reforcarAutomatico(Jogo *jogo, int jogador) {
+    int *alocacao = (int *)alocarArena(jogo->rascunho, jogo->total, sizeof(int));
+    if (alocacao == NULL) return 0;
+    otimizarReforco(jogo, jogador, calcularReforcos(jogo, jogador), alocacao);
+    int descartou = 0;
+    for (int t = jogo->primeiroDoJogador[jogador]; t >= 0; t = jogo->proximoDoJogador[t]) {
+        int tropas = alocacao[t];
+        if (tropas > jogo->limiteTropas - jogo->territorios[t].tropas) {
+            tropas = jogo->limiteTropas - jogo->territorios[t].tropas;
+            descartou = 1;
+        }
+        if (tropas > 0) alterarTropas(jogo, (size_t)t, tropas);
+    }
+    return descartou;
+}
+
+// remanejarAutomatico():
+// Remanejamento de um exército automático: a maior pilha do interior (empates com o menor índice) vai, menos uma
+// tropa, para o território de fronteira mais ameaçado da mesma região, sem passar de jogo->limiteTropas no destino.
+// Retorna 1 se o teto reduziu o movimento.
+static int remanejarAutomatico(Jogo *jogo, int jogador) {
+    const Territorio *territorios = jogo->territorios;
+    int origem = -1, destino = -1;
+    for (int t = jogo->primeiroDoJogador[jogador]; t >= 0; t = jogo->proximoDoJogador[t]) {
+        if (territorios[t].tropas > 1 && jogo->inimigosVizinhos[t] == 0 &&
+            (origem < 0 || territorios[t].tropas > territorios[origem].tropas)) {
+            origem = t;
+        }
+    }
+    if (origem < 0) return 0;
+    const double *ameaca = atualizarAmeacas(jogo);
+    for (int t = jogo->primeiroNaFronteira[jogador]; t >= 0; t = jogo->proximoNaFronteira[t]) {
+        if (mesmaRegiao(jogo, (size_t)origem, (size_t)t) && (destino < 0 || ameaca[t] > ameaca[destino])) {
+            destino = t;
+        }
+    }
+    if (destino < 0) return 0;
+    int quantidade = territorios[origem].tropas - 1;
+    int reduziu = quantidade > jogo->limiteTropas - territorios[destino].tropas;
+    if (reduziu) quantidade = jogo->limiteTropas - territorios[destino].tropas;
+    if (quantidade > 0) moverTropas(jogo, (size_t)origem, (size_t)destino, quantidade);
+    return reduziu;
+}
+
+// escolherAtaqueAutomatico():
+// Ataque preferido de um exército automático: o de maior chance de blitz ponderada pelo valor do alvo, entre os
+// que têm chance de ao menos limiarAtaque[jogador] e deixam ao menos 1 tropa além da guarnição na origem.
+// Empates ficam com os menores índices, então a escolha depende só da posição (não da ordem das listas).
+// Retorna 0 se não houver nenhum.
+static int escolherAtaqueAutomatico(const Jogo *jogo, int jogador, int *origem, int *alvo) {
+    const Territorio *territorios = jogo->territorios;
+    double melhor = 0.0;
+    *origem = *alvo = -1;
+    for (int t = jogo->primeiroNaFronteira[jogador]; t >= 0; t = jogo->proximoNaFronteira[t]) {
+        if (territorios[t].tropas < jogo->regras.guarnicao + 2) continue;
+        for (size_t v = jogo->inicioVizinhos[t]; v < jogo->inicioVizinhos[t + 1]; ++v) {
+            int e = jogo->vizinhos[v];
+            if (territorios[e].dono == jogador) continue;
+            double chance = probabilidadeBlitz(&jogo->blitz, territorios[t].tropas, territorios[e].tropas);
+            if (chance < jogo->limiarAtaque[jogador]) continue;
+            double pontuacao = chance * valorTerritorio(jogo, (size_t)e);
+            if (pontuacao > melhor || (pontuacao == melhor && *origem >= 0 && (t < *origem || (t == *origem && e < *alvo)))) {
+                melhor = pontuacao;
+                *origem = t;
+                *alvo = e;
+            }
+        }
+    }
+    return *origem >= 0;
+}
+
+// executarTurnoAutomatico():
+// Corpo de jogarTurnoAutomatico() (que devolve o rascunho do turno depois de qualquer saída).
+static int executarTurnoAutomatico(Jogo *jogo, int jogador) {
+    if (jogo->territoriosJogador[jogador] == 0) return 0;
+
+    reforcarAutomatico(jogo, jogador);
+    if (verificarVitoria(jogo, jogador)) return 1;
+
+    PlanoAtaque plano;
+    if (planejarAtaques(jogo, jogador, &plano) && plano.probabilidade >= jogo->limiarAtaque[jogador]) {
+        for (int i = 0; i < plano.total; ++i) {
+            if (!executarBlitz(jogo, (size_t)plano.origem[i], (size_t)plano.destino[i])) break;
+        }
+        if (verificarVitoria(jogo, jogador)) return 1;
+    }
+
+    for (int a = 0; a < ATAQUES_POR_TURNO; ++a) {
+        int origem, alvo;
+        if (!escolherAtaqueAutomatico(jogo, jogador, &origem, &alvo)) break;
+        if (executarBlitz(jogo, (size_t)origem, (size_t)alvo) && verificarVitoria(jogo, jogador)) return 1;
+    }
+
+    remanejarAutomatico(jogo, jogador);
+    return verificarVitoria(jogo, jogador);
+}
+
+// jogarTurnoAutomatico():
+// Joga o turno completo de um exército automático, sem saída na tela:
+// 1. reforço pelo otimizador (o mesmo dos oponentes da partida interativa);
+// 2. se o planejador achar um plano que cumpre a missão neste turno com chance de ao menos
+//    limiarAtaque[jogador], executa-o (parando na primeira blitz que falhar);
+// 3. até ATAQUES_POR_TURNO blitz, sempre o de maior chance ponderada pelo valor do alvo, enquanto a chance
+//    de conquista for ao menos limiarAtaque[jogador] (o atacante mantém ao menos 1 tropa);
+// 4. um remanejamento: a maior pilha do interior vai para o território de fronteira mais ameaçado da mesma região.
+// Reforço e remanejamento respeitam jogo->limiteTropas (sem teto nas partidas normais).
+// Ataques e destinos saem só da fronteira do jogador, mantida incrementalmente.
+// Ao final, a memória temporária do turno volta inteira para o rascunho da partida.
+// Retorna 1 assim que a missão do jogador for cumprida.
+int jogarTurnoAutomatico(Jogo *jogo, int jogador) {
+    int venceu = executarTurnoAutomatico(jogo, jogador);
+    reiniciarArena(jogo->rascunho);
+    return venceu;
+}
+
+// capacidadeRascunho():
+// Bytes de rascunho que um turno pode usar num mapa de 'total' territórios: o reforço (alocação e os quatro vetores
+// do otimizador, um elemento por território da fronteira) mais o planejador (objetivo, origens, contexto e o estado de até
+// LARGURA_PLANO subárvores), com folga para o alinhamento de cada fatia. Se um turno pedir mais, a arena cresce
+// e reiniciarArena() junta os blocos, então só os primeiros turnos chegariam a pedir memória ao sistema.
+size_t capacidadeRascunho(size_t total) {
+    size_t reforco = total * (2 * sizeof(int) + 3 * sizeof(double));
+    size_t plano = total + (total + 1) * sizeof(int) + sizeof(ContextoPlano) +
+                   LARGURA_PLANO * (sizeof(BuscaPlano) + total);
+    return reforco + plano + 16 * ALINHAMENTO_ARENA;
+}
+
+// simularPartida():
+// Distribui as missões e joga a partida com continuarPartida().
+int simularPartida(Jogo *jogo, int limiteRodadas) {
+    distribuirMissoes(jogo);
+    return continuarPartida(jogo, limiteRodadas);
+}
+
+// continuarPartida():
+// Joga rodadas completas (todos os exércitos vivos, em ordem de ID) só com exércitos automáticos, com as missões
+// já distribuídas. Retorna o ID de quem cumprir a missão primeiro ou -1 se ninguém cumprir em 'limiteRodadas'.
+int continuarPartida(Jogo *jogo, int limiteRodadas) {
+    for (jogo->rodada = 1; jogo->rodada <= limiteRodadas; jogo->rodada++) {
+        for (int j = 0; j < jogo->totalJogadores; ++j) {
+            if (jogarTurnoAutomatico(jogo, j)) return j;
+        }
+    }
+    jogo->rodada = limiteRodadas;
+    return -1;
+}
+
+// Resultado resumido de uma partida do simulador, usado pelos estimadores de taxa de vitória.
+typedef struct {
+    int vencedor;                            // ID do vencedor (-1 = sem vencedor)
+    int tipo;                                // tipo da missão do vencedor
+    int rodada;                              // rodada em que a partida terminou
+    double sortePorTipo[MISSAO_OCUPAR + 1];  // sorte somada dos jogadores com cada tipo de missão
+    double sorteJogador0;                    // sorte do jogador 0 (o das comparações de estratégia)
+    int batalhas;                            // blitz da partida, somadas entre todos os exércitos
+    long long tropasLider;                   // tropas do maior exército no fim da partida
+    double participacaoLider;                // fração de todas as tropas que está com o maior exército
+    double sorteVencedor;                    // sorte do vencedor (0 sem vencedor)
+    int missao;                              // ID no catálogo da missão do vencedor (-1 = sem vencedor)
+    int territoriosFinais[MAX_JOGADORES];    // territórios de cada exército no fim
+    int jogadores;                           // exércitos da partida (0 = o mapa não pôde ser criado)
+    char linha[MISS_DESC_TAM + 192];         // linha de resultado, impressa na ordem das partidas
+} ResultadoSimulacao;
+
+// Somas de uma amostra de pares (y, c) por unidade amostral: y é o valor medido e c uma variável de controle
+// de média conhecida igual a zero (a sorte nas blitz). Basta isso para média, variâncias e covariância.
+typedef struct {
+    double n, y, c, yy, cc, yc;
+} SomasEstimador;
+
+// acumularEstimador():
+// Acrescenta uma unidade amostral (y, c) às somas.
+static void acumularEstimador(SomasEstimador *s, double y, double c) {
+    s->n += 1.0;
+    s->y += y;
+    s->c += c;
+    s->yy += y * y;
+    s->cc += c * c;
+    s->yc += y * c;
+}
+
+// resumirEstimador():
+// Calcula a média simples (índice 0) e a média com variável de controle (índice 1): ȳ - β·c̄, com
+// β = cov(y, c) / var(c), já que E[c] = 0. Para cada uma devolve a variância por unidade e a meia largura do
+// intervalo de confiança de 95% (aproximação normal). Sem variação em 'c', o controle não muda nada.
+static void resumirEstimador(const SomasEstimador *s, double media[2], double variancia[2], double meiaLargura[2]) {
+    double n = s->n;
+    double my = n > 0.0 ? s->y / n : 0.0, mc = n > 0.0 ? s->c / n : 0.0;
+    double vy = 0.0, vc = 0.0, cov = 0.0;
+    if (n > 1.0) {
+        vy = (s->yy - n * my * my) / (n - 1.0);
+        vc = (s->cc - n * mc * mc) / (n - 1.0);
+        cov = (s->yc - n * my * mc) / (n - 1.0);
+    }
+    if (vy < 0.0) vy = 0.0;
+    double beta = vc > 1e-12 ? cov / vc : 0.0;
+    media[0] = my;
+    media[1] = my - beta * mc;
+    variancia[0] = vy;
+    variancia[1] = vy - beta * cov > 0.0 ? vy - beta * cov : 0.0;
+    for (int k = 0; k < 2; ++k) meiaLargura[k] = n > 0.0 ? 1.96 * sqrt(variancia[k] / n) : 0.0;
+}
+
+// Histograma HDR de inteiros entre 0 e 2^32 - 1: valores abaixo de 2^BITS_SUBFAIXAS_HDR têm faixa própria e cada
+// potência de 2 acima disso é dividida em 2^(BITS_SUBFAIXAS_HDR - 1) faixas iguais, então qualquer quantil sai com
+// erro relativo abaixo de 1/64 em memória fixa, sem guardar os valores. Juntar dois histogramas é somar as
+// contagens, o que não depende da ordem.
+typedef struct {
+    uint64_t contagem[FAIXAS_HDR];
+    uint64_t total;
+    uint32_t minimo, maximo;
+} HistogramaHDR;
+
+// indiceHDR():
+// Faixa do valor 'v': os valores pequenos são o próprio índice; para os outros, 'k' é quantos bits menos
+// significativos a faixa ignora e v >> k fica em [2^(B-1), 2^B).
+static size_t indiceHDR(uint32_t v) {
+    if (v < (UINT32_C(1) << BITS_SUBFAIXAS_HDR)) return v;
+    int k = 0;
+    while ((v >> k) >= (UINT32_C(1) << BITS_SUBFAIXAS_HDR)) k++;
+    return ((size_t)k << (BITS_SUBFAIXAS_HDR - 1)) + (v >> k);
+}
+
+// maiorValorHDR():
+// Maior valor que cai na faixa 'i' (inversa de indiceHDR()).
+static uint32_t maiorValorHDR(size_t i) {
+    if (i < ((size_t)1 << BITS_SUBFAIXAS_HDR)) return (uint32_t)i;
+    int k = (int)(i >> (BITS_SUBFAIXAS_HDR - 1)) - 1;
+    uint64_t m = i - ((size_t)k << (BITS_SUBFAIXAS_HDR - 1));
+    return (uint32_t)(((m + 1) << k) - 1);
+}
+
+// registrarHDR():
+// Conta um valor (valores fora de [0, 2^32 - 1] são saturados).
+static void registrarHDR(HistogramaHDR *h, long long valor) {
+    uint32_t v = valor < 0 ? 0 : valor > (long long)UINT32_MAX ? UINT32_MAX : (uint32_t)valor;
+    if (h->total == 0 || v < h->minimo) h->minimo = v;
+    if (h->total == 0 || v > h->maximo) h->maximo = v;
+    h->contagem[indiceHDR(v)]++;
+    h->total++;
+}
+
+// quantilHDR():
+// Menor valor (arredondado para o topo da faixa) com ao menos a fração 'q' dos valores abaixo ou igual.
+static uint32_t quantilHDR(const HistogramaHDR *h, double q) {
+    if (h->total == 0) return 0;
+    uint64_t posicao = (uint64_t)ceil(q * (double)h->total), acumulado = 0;
+    if (posicao < 1) posicao = 1;
+    for (size_t i = 0; i < FAIXAS_HDR; ++i) {
+        acumulado += h->contagem[i];
+        if (acumulado >= posicao) {
+            uint32_t v = maiorValorHDR(i);
+            return v < h->minimo ? h->minimo : v > h->maximo ? h->maximo : v;
+        }
+    }
+    return h->maximo;
+}
+
+// Centroide do t-digest: média e quantidade de valores que ele representa.
+typedef struct {
+    double media, peso;
+} Centroide;
+
+// t-digest de valores contínuos: os valores novos esperam em 'pendentes' e, quando o vetor enche, tudo é
+// ordenado e fundido em centroides cujo peso máximo encolhe perto das caudas (função de escala
+// k(q) = δ/Z · ln(q / (1 - q)), Z = 4·ln(n/δ) + 24), então os quantis extremos saem precisos em memória fixa.
+// Dois centroides vizinhos sempre cobrem mais de uma unidade de k, o que limita os comprimidos a 2δ.
+// Os centroides comprimidos vêm primeiro no vetor, seguidos dos pendentes.
+typedef struct {
+    Centroide centroides[2 * COMPRESSAO_TDIGEST + PENDENTES_TDIGEST];
+    int comprimidos, pendentes;
+    double total, minimo, maximo;
+} TDigest;
+
+// compararCentroides():
+// Ordem crescente de média (e de peso, para que empates também tenham ordem definida) para qsort().
+static int compararCentroides(const void *a, const void *b) {
+    const Centroide *x = (const Centroide *)a, *y = (const Centroide *)b;
+    if (x->media != y->media) return x->media < y->media ? -1 : 1;
+    return (x->peso > y->peso) - (x->peso < y->peso);
+}
+
+// limiteEscalaDigest():
+// Quantil até onde um centroide que começa no quantil 'q' pode crescer: k⁻¹(k(q) + 1), que fica em forma fechada
+// q / (q + (1 - q)·e^(-Z/δ)). Em q = 0 o limite é 0, então os valores extremos ficam sozinhos no próprio centroide.
+static double limiteEscalaDigest(double q, double total) {
+    double z = 4.0 * log(total > COMPRESSAO_TDIGEST ? total / COMPRESSAO_TDIGEST : 1.0) + 24.0;
+    return q / (q + (1.0 - q) * exp(-z / COMPRESSAO_TDIGEST));
+}
+
+// comprimirDigest():
+// Funde os pendentes com os centroides existentes em uma única passada pelos valores ordenados.
+static void comprimirDigest(TDigest *d) {
+    if (d->pendentes == 0) return;
+    int n = d->comprimidos + d->pendentes, saida = 0;
+    Centroide *c = d->centroides;
+    qsort(c, (size_t)n, sizeof(Centroide), compararCentroides);
+    double anterior = 0.0, limite = limiteEscalaDigest(0.0, d->total);
+    for (int i = 1; i < n; ++i) {
+        if ((anterior + c[saida].peso + c[i].peso) / d->total <= limite) {
+            c[saida].peso += c[i].peso;
+            c[saida].media += (c[i].media - c[saida].media) * c[i].peso / c[saida].peso;
+        } else {
+            anterior += c[saida].peso;
+            limite = limiteEscalaDigest(anterior / d->total, d->total);
+            c[++saida] = c[i];
+        }
+    }
+    d->comprimidos = saida + 1;
+    d->pendentes = 0;
+}
+
+// registrarDigest():
+// Acrescenta um valor ao t-digest.
+static void registrarDigest(TDigest *d, double valor) {
+    if (d->comprimidos + d->pendentes == 2 * COMPRESSAO_TDIGEST + PENDENTES_TDIGEST) comprimirDigest(d);
+    if (d->total == 0.0 || valor < d->minimo) d->minimo = valor;
+    if (d->total == 0.0 || valor > d->maximo) d->maximo = valor;
+    d->centroides[d->comprimidos + d->pendentes++] = (Centroide){valor, 1.0};
+    d->total += 1.0;
+}
+
+// quantilDigest():
+// Estima o quantil 'q' interpolando entre os centros dos centroides (e o mínimo e o máximo nas pontas).
+static double quantilDigest(TDigest *d, double q) {
+    comprimirDigest(d);
+    if (d->comprimidos == 0) return 0.0;
+    const Centroide *c = d->centroides;
+    int n = d->comprimidos;
+    double alvo = q * d->total;
+    if (alvo <= c[0].peso / 2.0) {
+        return d->minimo + (c[0].media - d->minimo) * (c[0].peso > 1.0 ? alvo / (c[0].peso / 2.0) : 1.0);
+    }
+    double acumulado = c[0].peso / 2.0; // posição do centro do centroide i
+    for (int i = 0; i + 1 < n; ++i) {
+        double passo = (c[i].peso + c[i + 1].peso) / 2.0;
+        if (alvo <= acumulado + passo) return c[i].media + (c[i + 1].media - c[i].media) * (alvo - acumulado) / passo;
+        acumulado += passo;
+    }
+    double resto = d->total - acumulado;
+    return resto > 0.0 ? c[n - 1].media + (d->maximo - c[n - 1].media) * (alvo - acumulado) / resto : d->maximo;
+}
+
+// simularComSemente():
+// Cria e joga uma partida do simulador com a semente dada. Com 'antitetica' os dados são os da sequência
+// antitética (o mapa, gerado antes, é o mesmo); 'limiarJogador0' > 0 muda a chance mínima de ataque do jogador 0.
+// Se 'rotulo' não for NULL, formata em r->linha uma linha com o resultado. Não imprime nada nem altera estado
+// compartilhado, então pode rodar em paralelo com outras partidas. Retorna 0 se o mapa não puder ser criado.
+static int simularComSemente(const Regras *regras, size_t territorios, int jogadores, uint64_t semente, int antitetica,
+                             double limiarJogador0, int limiteRodadas, const char *rotulo, ResultadoSimulacao *r) {
+    Jogo jogo;
+    memset(r, 0, sizeof(*r));
+    int criado = territorios > 0 ? criarJogoGerado(&jogo, regras, semente, territorios, jogadores)
+                                 : criarJogo(&jogo, regras, semente);
+    if (!criado) return 0;
+    if (antitetica) jogo.rng.inverter = ~UINT64_C(0);
+    if (limiarJogador0 > 0.0) jogo.limiarAtaque[0] = limiarJogador0;
+    r->vencedor = simularPartida(&jogo, limiteRodadas);
+    r->rodada = jogo.rodada;
+    r->tipo = r->vencedor >= 0 ? (int)jogo.catalogo[jogo.missoes[r->vencedor].id].tipo : -1;
+    r->missao = r->vencedor >= 0 ? jogo.missoes[r->vencedor].id : -1;
+    memcpy(r->territoriosFinais, jogo.territoriosJogador, (size_t)jogo.totalJogadores * sizeof(int));
+    for (int j = 0; j < jogo.totalJogadores; ++j) {
+        if (jogo.missoes[j].id >= 0) r->sortePorTipo[jogo.catalogo[jogo.missoes[j].id].tipo] += jogo.estatisticas[j].sorte;
+    }
+    r->sorteJogador0 = jogo.estatisticas[0].sorte;
+    r->sorteVencedor = r->vencedor >= 0 ? jogo.estatisticas[r->vencedor].sorte : 0.0;
+    long long *tropas = (long long *)calloc((size_t)jogo.totalJogadores, sizeof(long long));
+    if (tropas != NULL) {
+        long long todas = 0;
+        for (size_t t = 0; t < jogo.total; ++t) {
+            tropas[jogo.territorios[t].dono] += jogo.territorios[t].tropas;
+            todas += jogo.territorios[t].tropas;
+        }
+        for (int j = 0; j < jogo.totalJogadores; ++j) {
+            r->batalhas += jogo.estatisticas[j].batalhas;
+            if (tropas[j] > r->tropasLider) r->tropasLider = tropas[j];
+        }
+        r->participacaoLider = todas > 0 ? (double)r->tropasLider / (double)todas : 0.0;
+        free(tropas);
+    }
+    if (rotulo != NULL) {
+        if (r->vencedor < 0) {
+            snprintf(r->linha, sizeof(r->linha), "%s: sem vencedor em %d rodada(s)\n", rotulo, limiteRodadas);
+        } else {
+            char descricao[MISS_DESC_TAM], cor[24];
+            descreverMissao(&jogo, &jogo.missoes[r->vencedor], descricao, sizeof(descricao));
+            codigoCorJogador(r->vencedor, cor, sizeof(cor));
+            snprintf(r->linha, sizeof(r->linha), "%s: %s%s%s venceu na rodada %d (%d conquista(s)) - %s\n", rotulo, cor,
+                     jogo.nomesJogadores[r->vencedor], cor[0] != '\0' ? resetANSI : "", jogo.rodada,
+                     jogo.estatisticas[r->vencedor].conquistas, descricao);
+        }
+    }
+    r->jogadores = jogo.totalJogadores;
+    liberarMemoria(&jogo);
+    return 1;
+}
+
+// Progresso do subcomando "simular": parâmetros da execução e acumuladores parciais. É também o conteúdo do
+// arquivo de ponto de controle, gravado como está (formato binário desta máquina e desta versão do programa).
+// Cada partida semeia o próprio gerador com semente + número, então 'concluidas' já é a posição das sequências
+// aleatórias; os ponteiros de 'regras' (nome e kernel) são refeitos na leitura a partir de 'nomeRegras'.
+typedef struct {
+    char magica[8];               // MAGICA_CONTROLE (sem o '\0')
+    uint32_t tamanho;             // sizeof(ProgressoSimulacao): recusa arquivos de outra versão
+    char nomeRegras[16];
+    Regras regras;
+    uint64_t territorios;
+    uint64_t semente;
+    int jogadores;
+    int partidas;
+    int limiteRodadas;
+    int antiteticas;
+    double limiarComparado;
+    int concluidas;               // partidas (ou pares) já somadas aos acumuladores
+    int vitorias[MAX_JOGADORES];
+    int vitoriasPorTipo[MISSAO_OCUPAR + 1];
+    int empates;
+    long long somaRodadas;
+    // por tipo de missão: a unidade (partida ou par antitético) e cada partida isolada (referência do ganho)
+    SomasEstimador porTipo[MISSAO_OCUPAR + 1];
+    SomasEstimador porTipoIsolada[MISSAO_OCUPAR + 1];
+    // comparação de estratégias: vitória do jogador 0 em cada braço e a diferença pareada
+    SomasEstimador padrao, variante, diferenca, padraoIsolada, varianteIsolada;
+    // distribuições por partida (caudas que a média esconde), sem guardar os valores de cada partida
+    HistogramaHDR rodadas, batalhas, tropasLider;
+    TDigest participacaoLider, sorteVencedor;
+    // exportação colunar (diretório vazio = desligada): tamanho de cada arquivo quando o progresso foi gravado
+    char diretorioColunas[TAM_LINHA];
+    uint64_t bytesColunas[TOTAL_COLUNAS];
+} ProgressoSimulacao;
+
+// Pedido de interrupção (SIGINT/SIGTERM) recebido durante uma simulação com ponto de controle.
+static volatile sig_atomic_t interrupcaoPedida = 0;
+
+// pedirInterrupcao():
+// Tratador de sinal: só anota o pedido; o simulador grava o ponto de controle ao fim do lote em andamento.
+static void pedirInterrupcao(int sinal) {
+    (void)sinal;
+    interrupcaoPedida = 1;
+}
+
+// Lote de partidas do simulador jogado em paralelo: cada unidade (número de partida) joga todos os seus braços e
+// cópias antitéticas e guarda os resultados em resultados[(unidade * bracos + braco) * copias + copia].
+typedef struct {
+    const ProgressoSimulacao *progresso;
+    int inicio;                     // número da primeira partida do lote
+    int bracos;                     // 2 com --comparar-limiar, senão 1
+    int copias;                     // 2 com --antiteticas, senão 1
+    ResultadoSimulacao *resultados;
+} ContextoSimulacao;
+
+// simularUnidade():
+// Tarefa paralela: joga a partida inicio + indice. A semente vem só do número da partida (semente base + número,
+// espalhada pelo splitmix64 em semearGerador()), então o resultado não depende de qual thread a jogou nem de
+// quantas threads existem.
+static void simularUnidade(void *contexto, size_t indice) {
+    ContextoSimulacao *ctx = (ContextoSimulacao *)contexto;
+    const ProgressoSimulacao *s = ctx->progresso;
+    int p = ctx->inicio + (int)indice;
+    uint64_t sementePartida = s->semente + (uint64_t)p;
+    char rotulo[96];
+    for (int braco = 0; braco < ctx->bracos; ++braco) {
+        for (int copia = 0; copia < ctx->copias; ++copia) {
+            snprintf(rotulo, sizeof(rotulo), "Partida %d (semente %llu%s)", p + 1,
+                     (unsigned long long)sementePartida, copia ? ", antitética" : "");
+            simularComSemente(&s->regras, (size_t)s->territorios, s->jogadores, sementePartida, copia,
+                              braco ? s->limiarComparado : 0.0, s->limiteRodadas, braco == 0 ? rotulo : NULL,
+                              &ctx->resultados[(indice * (size_t)ctx->bracos + (size_t)braco) * (size_t)ctx->copias +
+                                               (size_t)copia]);
+        }
+    }
+}
+
+// Exportação colunar em andamento: um arquivo e um bloco em memória por coluna, todos com as mesmas linhas.
+typedef struct {
+    FILE *arquivo[TOTAL_COLUNAS];
+    unsigned char *bloco[TOTAL_COLUNAS];
+    CabecalhoColuna cabecalho[TOTAL_COLUNAS];
+    uint32_t linhas;                        // linhas no bloco em memória
+} ExportacaoColunar;
+
+// abrirColunas():
+// Cria o diretório e os arquivos das colunas ('bytes' NULL) ou, ao retomar, corta cada arquivo no tamanho gravado
+// no ponto de controle (descartando blocos de partidas que serão jogadas de novo) e continua no fim dele.
+// 'jogadores' é a largura da coluna de territórios. Retorna 0 em caso de erro (fecharColunas() libera o resto).
+static int abrirColunas(ExportacaoColunar *e, const char *diretorio, int jogadores, const uint64_t *bytes) {
+    memset(e, 0, sizeof(*e));
+    if (bytes == NULL && mkdir(diretorio, 0777) != 0 && errno != EEXIST) return 0;
+    for (int c = 0; c < TOTAL_COLUNAS; ++c) {
+        CabecalhoColuna *cabecalho = &e->cabecalho[c];
+        memcpy(cabecalho->magica, MAGICA_COLUNA, sizeof(cabecalho->magica));
+        cabecalho->largura = c == COLUNA_TERRITORIOS ? (uint32_t)jogadores : 1;
+        cabecalho->bytesValor = c == COLUNA_SEMENTE ? 8 : 4;
+        e->bloco[c] = (unsigned char *)malloc((size_t)LINHAS_BLOCO_COLUNA * cabecalho->largura * cabecalho->bytesValor);
+        char caminho[2 * TAM_LINHA];
+        snprintf(caminho, sizeof(caminho), "%s/%s.col", diretorio, nomesColunas[c]);
+        if (e->bloco[c] == NULL) return 0;
+        if (bytes == NULL) {
+            e->arquivo[c] = fopen(caminho, "wb");
+            if (e->arquivo[c] == NULL || fwrite(cabecalho, sizeof(*cabecalho), 1, e->arquivo[c]) != 1) return 0;
+        } else {
+            struct stat info;
+            e->arquivo[c] = fopen(caminho, "r+b");
+            if (e->arquivo[c] == NULL) return 0;
+            int fd = fileno(e->arquivo[c]);
+            if (fstat(fd, &info) != 0 || (uint64_t)info.st_size < bytes[c] || ftruncate(fd, (off_t)bytes[c]) != 0 ||
+                fseek(e->arquivo[c], 0, SEEK_END) != 0) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// descarregarColunas():
+// Grava o bloco em memória de cada coluna (cabeçalho com mínimo e máximo, depois os valores). Retorna 0 em erro.
+static int descarregarColunas(ExportacaoColunar *e) {
+    if (e->linhas == 0) return 1;
+    int ok = 1;
+    for (int c = 0; c < TOTAL_COLUNAS; ++c) {
+        size_t valores = (size_t)e->linhas * e->cabecalho[c].largura;
+        CabecalhoBloco bloco = {e->linhas, 0, 0, 0};
+        if (e->cabecalho[c].bytesValor == 8) {
+            const uint64_t *v = (const uint64_t *)e->bloco[c];
+            bloco.minimo = bloco.maximo = v[0];
+            for (size_t i = 1; i < valores; ++i) {
+                if (v[i] < bloco.minimo) bloco.minimo = v[i];
+                if (v[i] > bloco.maximo) bloco.maximo = v[i];
+            }
+        } else {
+            const int32_t *v = (const int32_t *)e->bloco[c];
+            int32_t minimo = v[0], maximo = v[0];
+            for (size_t i = 1; i < valores; ++i) {
+                if (v[i] < minimo) minimo = v[i];
+                if (v[i] > maximo) maximo = v[i];
+            }
+            bloco.minimo = (uint64_t)(int64_t)minimo;
+            bloco.maximo = (uint64_t)(int64_t)maximo;
+        }
+        ok = ok && fwrite(&bloco, sizeof(bloco), 1, e->arquivo[c]) == 1 &&
+             fwrite(e->bloco[c], e->cabecalho[c].bytesValor, valores, e->arquivo[c]) == valores;
+    }
+    e->linhas = 0;
+    return ok;
+}
+
+// acrescentarColunas():
+// Acrescenta a linha de uma partida ('copia' = 1 na cópia antitética); o bloco vai para os arquivos quando enche.
+// Retorna 0 em erro.
+static int acrescentarColunas(ExportacaoColunar *e, uint64_t semente, int copia, const ResultadoSimulacao *r) {
+    int32_t valores[] = {r->vencedor, r->missao, r->tipo, r->rodada, r->batalhas, copia};
+    ((uint64_t *)e->bloco[COLUNA_SEMENTE])[e->linhas] = semente;
+    for (int c = COLUNA_VENCEDOR; c <= COLUNA_ANTITETICA; ++c) ((int32_t *)e->bloco[c])[e->linhas] = valores[c - COLUNA_VENCEDOR];
+    uint32_t largura = e->cabecalho[COLUNA_TERRITORIOS].largura;
+    int32_t *territorios = (int32_t *)e->bloco[COLUNA_TERRITORIOS] + (size_t)e->linhas * largura;
+    for (uint32_t j = 0; j < largura; ++j) territorios[j] = (int)j < r->jogadores ? r->territoriosFinais[j] : 0;
+    return ++e->linhas < LINHAS_BLOCO_COLUNA || descarregarColunas(e);
+}
+
+// posicoesColunas():
+// Descarrega o bloco em memória e anota o tamanho de cada arquivo (para o ponto de controle). Retorna 0 em erro.
+static int posicoesColunas(ExportacaoColunar *e, uint64_t bytes[TOTAL_COLUNAS]) {
+    if (!descarregarColunas(e)) return 0;
+    for (int c = 0; c < TOTAL_COLUNAS; ++c) {
+        if (fflush(e->arquivo[c]) != 0) return 0;
+        long posicao = ftell(e->arquivo[c]);
+        if (posicao < 0) return 0;
+        bytes[c] = (uint64_t)posicao;
+    }
+    return 1;
+}
+
+// fecharColunas():
+// Grava o último bloco, fecha os arquivos e libera os blocos. Retorna 0 se alguma gravação falhou.
+static int fecharColunas(ExportacaoColunar *e) {
+    int ok = e->arquivo[TOTAL_COLUNAS - 1] != NULL && descarregarColunas(e);
+    for (int c = 0; c < TOTAL_COLUNAS; ++c) {
+        if (e->arquivo[c] != NULL && fclose(e->arquivo[c]) != 0) ok = 0;
+        free(e->bloco[c]);
+    }
+    memset(e, 0, sizeof(*e));
+    return ok;
+}
+
+// gravarPontoControle():
+// Grava o progresso em um arquivo temporário e o renomeia por cima do anterior, para que uma interrupção no
+// meio da gravação nunca deixe um ponto de controle pela metade. Retorna 0 em caso de erro.
+static int gravarPontoControle(const char *arquivo, const ProgressoSimulacao *progresso) {
+    char temporario[TAM_LINHA + 8];
+    snprintf(temporario, sizeof(temporario), "%s.tmp", arquivo);
+    FILE *f = fopen(temporario, "wb");
+    if (f == NULL) return 0;
+    int ok = fwrite(progresso, sizeof(*progresso), 1, f) == 1;
+    ok = fclose(f) == 0 && ok;
+    if (ok) ok = rename(temporario, arquivo) == 0;
+    if (!ok) remove(temporario);
+    return ok;
+}
+
+// lerPontoControle():
+// Lê um ponto de controle gravado por gravarPontoControle() e refaz os ponteiros das regras.
+// Retorna 0 se o arquivo não existir, for de outra versão ou estiver corrompido.
+static int lerPontoControle(const char *arquivo, ProgressoSimulacao *progresso) {
+    FILE *f = fopen(arquivo, "rb");
+    if (f == NULL) return 0;
+    int ok = fread(progresso, sizeof(*progresso), 1, f) == 1 && fgetc(f) == EOF;
+    fclose(f);
+    if (!ok || memcmp(progresso->magica, MAGICA_CONTROLE, sizeof(progresso->magica)) != 0 ||
+        progresso->tamanho != sizeof(*progresso) || progresso->concluidas < 0 ||
+        progresso->concluidas > progresso->partidas) {
+        return 0;
+    }
+    progresso->nomeRegras[sizeof(progresso->nomeRegras) - 1] = '\0';
+    const Regras *base = buscarRegras(progresso->nomeRegras);
+    progresso->regras.nome = base != NULL ? base->nome : variantesRegras[0].nome;
+    return prepararRegras(&progresso->regras);
+}
+
+// executarSimulacoes():
+// Subcomando "simular": roda várias partidas entre exércitos automáticos (por exemplo, battle royale com
+// 100 exércitos em um mapa gerado de milhares de territórios) e resume vencedores, missões e rodadas.
+// Cada partida usa a semente base mais o seu número, então uma execução pode ser repetida exatamente. As partidas
+// rodam em paralelo em lotes de LOTE_SIMULACAO e os resultados são somados na ordem das partidas: a saída é a
+// mesma com qualquer número de threads.
+// As taxas de vitória por tipo de missão saem com intervalo de confiança de 95%, também corrigidas pela sorte
+// nas blitz (variável de controle de média exata zero). Com --antiteticas cada semente é jogada também com os
+// dados antitéticos e a unidade amostral passa a ser o par. Com --comparar-limiar X cada semente é jogada de
+// novo com o jogador 0 atacando a partir da chance X (números aleatórios comuns): a diferença entre as duas
+// estratégias é estimada partida a partida. O "ganho" é quantas vezes a variância ficou menor do que a de
+// partidas independentes simples com o mesmo total de partidas.
+// Com --controle ARQUIVO o progresso é gravado a cada --intervalo partidas (e ao receber SIGINT/SIGTERM, que
+// encerram a execução depois do lote em andamento); --retomar ARQUIVO continua de onde o ponto de controle
+// parou, com os parâmetros gravados nele, e chega a um resumo idêntico ao de uma execução sem interrupção
+// (só --threads e --intervalo podem acompanhá-lo; as demais opções gravadas no ponto de controle são recusadas).
+// Com --colunas DIRETORIO cada partida vira também uma linha da exportação colunar (um arquivo binário por coluna,
+// em blocos com mínimo e máximo; com --antiteticas as duas cópias do par têm a mesma semente e a coluna
+// 'antitetica' as separa), gravada enquanto as partidas terminam; o ponto de controle guarda o tamanho
+// de cada arquivo, e a retomada corta o que foi gravado depois dele.
+int executarSimulacoes(int argc, char *argv[]) {
+    ProgressoSimulacao s;
+    memset(&s, 0, sizeof(s)); // zera também o preenchimento, para o arquivo gravado ser determinístico
+    memcpy(s.magica, MAGICA_CONTROLE, sizeof(s.magica));
+    s.tamanho = sizeof(s);
+    s.regras = variantesRegras[0];
+    s.partidas = 1;
+    s.limiteRodadas = RODADAS_SIMULACAO;
+    s.semente = (uint64_t)time(NULL);
+    const char *arquivoControle = NULL;
+    int intervalo = INTERVALO_CONTROLE, retomar = 0;
+    const char *opcaoGravada = NULL; // primeira opção que o ponto de controle substituiria ao retomar
+    size_t territoriosMapa = 0;
+    int jogadoresMapa = 0;
+    for (int i = 1; i < argc; ++i) {
+        const char *opcao = argv[i];
+        int lida = lerOpcaoRegras(argc, argv, &i, &s.regras);
+        if (lida == 0) lida = lerOpcaoMapa(argc, argv, &i, &territoriosMapa, &jogadoresMapa);
+        if (lida < 0) return EXIT_FAILURE;
+        if (strcmp(opcao, "--threads") != 0 && strcmp(opcao, "--intervalo") != 0 &&
+            strcmp(opcao, "--controle") != 0 && strcmp(opcao, "--retomar") != 0 && opcaoGravada == NULL) {
+            opcaoGravada = opcao;
+        }
+        if (lida > 0) continue;
+        if (strcmp(argv[i], "--partidas") == 0 && i + 1 < argc) {
+            s.partidas = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rodadas") == 0 && i + 1 < argc) {
+            s.limiteRodadas = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--semente") == 0 && i + 1 < argc) {
+            s.semente = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--antiteticas") == 0) {
+            s.antiteticas = 1;
+        } else if (strcmp(argv[i], "--comparar-limiar") == 0 && i + 1 < argc) {
+            s.limiarComparado = strtod(argv[++i], NULL);
+            if (s.limiarComparado <= 0.0 || s.limiarComparado > 1.0) {
+                fprintf(stderr, "Erro: --comparar-limiar espera uma chance entre 0 e 1.\n");
+                return EXIT_FAILURE;
+            }
+        } else if ((strcmp(argv[i], "--controle") == 0 || strcmp(argv[i], "--retomar") == 0) && i + 1 < argc) {
+            retomar = strcmp(argv[i], "--retomar") == 0;
+            arquivoControle = argv[++i];
+        } else if (strcmp(argv[i], "--colunas") == 0 && i + 1 < argc) {
+            if (strlen(argv[++i]) >= sizeof(s.diretorioColunas)) {
+                fprintf(stderr, "Erro: nome do diretório da exportação colunar longo demais.\n");
+                return EXIT_FAILURE;
+            }
+            strcpy(s.diretorioColunas, argv[i]);
+        } else if (strcmp(argv[i], "--intervalo") == 0 && i + 1 < argc) {
+            intervalo = atoi(argv[++i]);
+            if (intervalo < 1) {
+                fprintf(stderr, "Erro: --intervalo espera um número de partidas maior que zero.\n");
+                return EXIT_FAILURE;
+            }
+        } else {
+            fprintf(stderr, "Uso: war simular [--territorios N (0 = mapa padrão)] [--jogadores 2..%d] [--partidas N]\n"
+                            "                 [--rodadas N] [--semente N] [--antiteticas] [--comparar-limiar 0..1]\n"
+                            "                 [--controle ARQUIVO [--intervalo N] | --retomar ARQUIVO] [--colunas DIRETORIO]\n"
+                            "                 [opções de regras] [--threads N]\n", MAX_JOGADORES);
+            return EXIT_FAILURE;
+        }
+    }
+    if (arquivoControle != NULL && strlen(arquivoControle) >= TAM_LINHA) {
+        fprintf(stderr, "Erro: nome do arquivo de ponto de controle longo demais.\n");
+        return EXIT_FAILURE;
+    }
+    if (retomar && opcaoGravada != NULL) {
+        fprintf(stderr, "Erro: %s não pode ser usada com --retomar (a execução continua com os parâmetros gravados "
+                        "no ponto de controle; só --threads e --intervalo podem mudar).\n", opcaoGravada);
+        return EXIT_FAILURE;
+    }
+    if (!retomar) {
+        if (!conferirOpcaoMapa(territoriosMapa, &jogadoresMapa)) return EXIT_FAILURE;
+        s.territorios = territoriosMapa;
+        s.jogadores = jogadoresMapa;
+    }
+    if (retomar) {
+        if (!lerPontoControle(arquivoControle, &s)) {
+            fprintf(stderr, "Erro: '%s' não é um ponto de controle válido desta versão do simulador.\n", arquivoControle);
+            return EXIT_FAILURE;
+        }
+        printf("Retomando '%s': %d de %d partida(s) já concluída(s) (semente %llu, regras %s)\n", arquivoControle,
+               s.concluidas, s.partidas, (unsigned long long)s.semente, s.regras.nome);
+    } else if (!prepararRegras(&s.regras)) {
+        fprintf(stderr, "Erro: combinação de regras inválida (dados entre 1 e %d, mínimo na conquista >= 1).\n", MAX_DADOS);
+        return EXIT_FAILURE;
+    }
+    snprintf(s.nomeRegras, sizeof(s.nomeRegras), "%s", s.regras.nome);
+    if (arquivoControle != NULL) {
+        interrupcaoPedida = 0;
+        signal(SIGINT, pedirInterrupcao);
+        signal(SIGTERM, pedirInterrupcao);
+    }
+
+    int copias = s.antiteticas ? 2 : 1, bracos = s.limiarComparado > 0.0 ? 2 : 1;
+    ContextoSimulacao lote = {&s, 0, bracos, copias, NULL};
+    lote.resultados = (ResultadoSimulacao *)malloc((size_t)LOTE_SIMULACAO * (size_t)(bracos * copias) *
+                                                   sizeof(ResultadoSimulacao));
+    if (lote.resultados == NULL) {
+        fprintf(stderr, "Erro: memória insuficiente para o simulador.\n");
+        return EXIT_FAILURE;
+    }
+    int codigo = EXIT_SUCCESS;
+    ExportacaoColunar colunas = {0};
+    int exportar = s.diretorioColunas[0] != '\0';
+    // no mapa padrão a partida sempre tem os exércitos clássicos, qualquer que seja --jogadores
+    if (exportar && !abrirColunas(&colunas, s.diretorioColunas, s.territorios > 0 ? s.jogadores : TOTAL_JOGADORES,
+                                  retomar ? s.bytesColunas : NULL)) {
+        fprintf(stderr, "Erro: não foi possível %s a exportação colunar em '%s'.\n", retomar ? "retomar" : "criar",
+                s.diretorioColunas);
+        codigo = EXIT_FAILURE;
+        goto fim;
+    }
+    while (s.concluidas < s.partidas) {
+        lote.inicio = s.concluidas;
+        int unidades = s.partidas - lote.inicio < LOTE_SIMULACAO ? s.partidas - lote.inicio : LOTE_SIMULACAO;
+        executarEmParalelo((size_t)unidades, simularUnidade, &lote);
+        // soma na ordem das partidas, qualquer que tenha sido a ordem em que as threads as terminaram
+        for (int u = 0; u < unidades; ++u) {
+            const ResultadoSimulacao *unidade = &lote.resultados[(size_t)u * (size_t)(bracos * copias)];
+            double y[MISSAO_OCUPAR + 1] = {0}, c[MISSAO_OCUPAR + 1] = {0};
+            double vitoriaBraco[2] = {0}, sorteBraco[2] = {0};
+            for (int braco = 0; braco < bracos; ++braco) {
+                for (int copia = 0; copia < copias; ++copia) {
+                    const ResultadoSimulacao *r = &unidade[braco * copias + copia];
+                    if (r->jogadores == 0) {
+                        fprintf(stderr, "Erro: não foi possível criar o mapa (2 a %d jogadores, ao menos um território por jogador).\n",
+                                MAX_JOGADORES);
+                        codigo = EXIT_FAILURE;
+                        goto fim;
+                    }
+                    s.jogadores = r->jogadores;
+                    double venceu0 = r->vencedor == 0;
+                    vitoriaBraco[braco] += venceu0 / copias;
+                    sorteBraco[braco] += r->sorteJogador0 / copias;
+                    acumularEstimador(braco ? &s.varianteIsolada : &s.padraoIsolada, venceu0, 0.0);
+                    if (braco > 0) continue;
+                    fputs(r->linha, stdout);
+                    if (exportar && !acrescentarColunas(&colunas, s.semente + (uint64_t)(lote.inicio + u), copia, r)) {
+                        fprintf(stderr, "Erro: não foi possível gravar a exportação colunar em '%s'.\n", s.diretorioColunas);
+                        codigo = EXIT_FAILURE;
+                        goto fim;
+                    }
+                    s.somaRodadas += r->rodada;
+                    registrarHDR(&s.rodadas, r->rodada);
+                    registrarHDR(&s.batalhas, r->batalhas);
+                    registrarHDR(&s.tropasLider, r->tropasLider);
+                    registrarDigest(&s.participacaoLider, r->participacaoLider);
+                    if (r->vencedor >= 0) registrarDigest(&s.sorteVencedor, r->sorteVencedor);
+                    if (r->vencedor < 0) {
+                        s.empates++;
+                    } else {
+                        s.vitorias[r->vencedor]++;
+                        s.vitoriasPorTipo[r->tipo]++;
+                    }
+                    for (int t = 0; t <= MISSAO_OCUPAR; ++t) {
+                        y[t] += (double)(r->tipo == t) / copias;
+                        c[t] += r->sortePorTipo[t] / copias;
+                        acumularEstimador(&s.porTipoIsolada[t], r->tipo == t, r->sortePorTipo[t]);
+                    }
+                }
+            }
+            for (int t = 0; t <= MISSAO_OCUPAR; ++t) acumularEstimador(&s.porTipo[t], y[t], c[t]);
+            if (bracos > 1) {
+                acumularEstimador(&s.padrao, vitoriaBraco[0], sorteBraco[0]);
+                acumularEstimador(&s.variante, vitoriaBraco[1], sorteBraco[1]);
+                acumularEstimador(&s.diferenca, vitoriaBraco[1] - vitoriaBraco[0], sorteBraco[1] - sorteBraco[0]);
+            }
+            s.concluidas++;
+            if (arquivoControle != NULL && (s.concluidas % intervalo == 0 || s.concluidas == s.partidas || interrupcaoPedida)) {
+                if ((exportar && !posicoesColunas(&colunas, s.bytesColunas)) || !gravarPontoControle(arquivoControle, &s)) {
+                    fprintf(stderr, "Erro: não foi possível gravar o ponto de controle '%s'.\n", arquivoControle);
+                    codigo = EXIT_FAILURE;
+                    goto fim;
+                }
+                if (interrupcaoPedida && s.concluidas < s.partidas) {
+                    printf("Interrompido após %d de %d partida(s); continue com: war simular --retomar %s\n",
+                           s.concluidas, s.partidas, arquivoControle);
+                    codigo = EXIT_FAILURE;
+                    goto fim;
+                }
+            }
+        }
+    }
+fim:
+    free(lote.resultados);
+    if (exportar && !fecharColunas(&colunas) && codigo == EXIT_SUCCESS) {
+        fprintf(stderr, "Erro: não foi possível gravar a exportação colunar em '%s'.\n", s.diretorioColunas);
+        codigo = EXIT_FAILURE;
+    }
+    if (codigo != EXIT_SUCCESS) return codigo;
+
+    int partidas = s.partidas, jogadores = s.jogadores, total = partidas * copias;
+    char cor[24];
+    printf("\n=== Resumo: %d partida(s), %d exército(s), regras %s ===\n", total, jogadores, s.regras.nome);
+    printf("Rodadas em média: %.1f | sem vencedor: %d\n", total > 0 ? (double)s.somaRodadas / total : 0.0, s.empates);
+    printf("Vitórias por missão: destruir %d, territórios %d, continentes %d, ocupar %d\n",
+           s.vitoriasPorTipo[MISSAO_DESTRUIR], s.vitoriasPorTipo[MISSAO_TERRITORIOS],
+           s.vitoriasPorTipo[MISSAO_CONTINENTES], s.vitoriasPorTipo[MISSAO_OCUPAR]);
+    for (int j = 0; j < jogadores; ++j) {
+        if (s.vitorias[j] == 0) continue;
+        codigoCorJogador(j, cor, sizeof(cor));
+        char nome[TAM_COR];
+        nomearJogador(j, nome, sizeof(nome));
+        printf("  %s%-14s%s %d vitória(s)\n", cor, nome, cor[0] != '\0' ? resetANSI : "", s.vitorias[j]);
+    }
+    static const double quantis[] = {0.5, 0.9, 0.99, 0.999};
+    printf("Distribuições por partida (p50 / p90 / p99 / p99.9 / máximo):\n");
+    const HistogramaHDR *inteiros[] = {&s.rodadas, &s.batalhas, &s.tropasLider};
+    // nomes já alinhados na mesma largura visível, como os tipos de missão abaixo
+    static const char *nomesInteiros[] = {"rodadas                 ", "blitz                   ",
+                                          "tropas do maior exército"};
+    for (int k = 0; k < 3; ++k) {
+        printf("  %s", nomesInteiros[k]);
+        for (int q = 0; q < 4; ++q) printf(" %u /", quantilHDR(inteiros[k], quantis[q]));
+        printf(" %u\n", inteiros[k]->maximo);
+    }
+    printf("  fatia das tropas        ");
+    for (int q = 0; q < 4; ++q) printf(" %.1f%% /", 100.0 * quantilDigest(&s.participacaoLider, quantis[q]));
+    printf(" %.1f%%\n", 100.0 * s.participacaoLider.maximo);
+    if (s.sorteVencedor.total > 0.0) {
+        printf("  sorte do vencedor       ");
+        for (int q = 0; q < 4; ++q) printf(" %+.2f /", quantilDigest(&s.sorteVencedor, quantis[q]));
+        printf(" %+.2f\n", s.sorteVencedor.maximo);
+    }
+    if (partidas < 2) return EXIT_SUCCESS;
+
+    // nomes já alinhados na mesma largura visível ('ó' ocupa dois bytes, então %-Ns não serve)
+    static const char *nomesTipos[MISSAO_OCUPAR + 1] = {"destruir   ", "territórios", "continentes", "ocupar     "};
+    double media[2], variancia[2], meia[2], mediaIsolada[2], varianciaIsolada[2], meiaIsolada[2];
+    printf("Taxa de vitória por missão (IC 95%%, %d %s; controle: sorte nas blitz):\n", partidas,
+           s.antiteticas ? "pares antitéticos" : "partidas");
+    for (int t = 0; t <= MISSAO_OCUPAR; ++t) {
+        resumirEstimador(&s.porTipo[t], media, variancia, meia);
+        resumirEstimador(&s.porTipoIsolada[t], mediaIsolada, varianciaIsolada, meiaIsolada);
+        printf("  %s %6.2f%% ± %5.2f%% | com controle %6.2f%% ± %5.2f%%", nomesTipos[t],
+               100.0 * media[0], 100.0 * meia[0], 100.0 * media[1], 100.0 * meia[1]);
+        if (variancia[1] > 0.0) printf(" | ganho %.2fx", (varianciaIsolada[0] / total) / (variancia[1] / partidas));
+        printf("\n");
+    }
+    if (s.limiarComparado > 0.0) {
+        char nome[TAM_COR];
+        nomearJogador(0, nome, sizeof(nome));
+        codigoCorJogador(0, cor, sizeof(cor));
+        printf("Comparação com números aleatórios comuns: %s%s%s atacando a partir de %.2f (padrão %.2f)\n",
+               cor, nome, cor[0] != '\0' ? resetANSI : "", s.limiarComparado, LIMIAR_ATAQUE_AUTOMATICO);
+        resumirEstimador(&s.padrao, media, variancia, meia);
+        printf("  padrão    %6.2f%% ± %5.2f%% |", 100.0 * media[0], 100.0 * meia[0]);
+        resumirEstimador(&s.variante, media, variancia, meia);
+        printf(" variante %6.2f%% ± %5.2f%%\n", 100.0 * media[0], 100.0 * meia[0]);
+        resumirEstimador(&s.diferenca, media, variancia, meia);
+        resumirEstimador(&s.padraoIsolada, mediaIsolada, varianciaIsolada, meiaIsolada);
+        double independente = varianciaIsolada[0];
+        resumirEstimador(&s.varianteIsolada, mediaIsolada, varianciaIsolada, meiaIsolada);
+        independente = (independente + varianciaIsolada[0]) / total;
+        printf("  diferença %+6.2f%% ± %5.2f%% | com controle %+6.2f%% ± %5.2f%%", 100.0 * media[0], 100.0 * meia[0],
+               100.0 * media[1], 100.0 * meia[1]);
+        if (variancia[1] > 0.0) printf(" | ganho %.2fx sobre sementes independentes", independente / (variancia[1] / partidas));
+        printf("\n");
+    }
+    return EXIT_SUCCESS;
+}
+
+// Coluna da exportação colunar mapeada na memória (somente leitura), percorrida bloco a bloco.
+typedef struct {
+    const unsigned char *dados;
+    size_t tamanho;
+    size_t posicao;                // início do próximo bloco
+    CabecalhoColuna cabecalho;
+} ColunaMapeada;
+
+// Filtro de uma consulta: linhas com valor da coluna entre 'minimo' e 'maximo' (sem sinal na coluna de 8 bytes,
+// com sinal nas de 4 bytes, como nos cabeçalhos de bloco).
+typedef struct {
+    int coluna;
+    uint64_t minimo, maximo;
+} FiltroConsulta;
+
+// Quatro inteiros de 32 bits em um registrador SIMD (extensão de vetores do GCC/Clang).
+typedef int32_t VetorInt32 __attribute__((vector_size(16)));
+
+// Um grupo do resultado de uma consulta; o histograma da coluna medida só é alocado quando o grupo aparece.
+typedef struct {
+    long long partidas;
+    double soma;
+    HistogramaHDR *medida;
+} GrupoConsulta;
+
+// mapearColuna():
+// Mapeia DIRETORIO/<coluna>.col e valida o cabeçalho. Retorna 0 se o arquivo não existir ou não for uma coluna.
+static int mapearColuna(const char *diretorio, int coluna, ColunaMapeada *col) {
+    char caminho[2 * TAM_LINHA];
+    snprintf(caminho, sizeof(caminho), "%s/%s.col", diretorio, nomesColunas[coluna]);
+    memset(col, 0, sizeof(*col));
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(CabecalhoColuna)) {
+        close(fd);
+        return 0;
+    }
+    void *dados = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (dados == MAP_FAILED) return 0;
+    col->dados = (const unsigned char *)dados;
+    col->tamanho = (size_t)info.st_size;
+    col->posicao = sizeof(CabecalhoColuna);
+    memcpy(&col->cabecalho, col->dados, sizeof(col->cabecalho));
+    uint32_t esperado = coluna == COLUNA_SEMENTE ? 8 : 4;
+    if (memcmp(col->cabecalho.magica, MAGICA_COLUNA, sizeof(col->cabecalho.magica)) != 0 ||
+        col->cabecalho.bytesValor != esperado || col->cabecalho.largura != 1) {
+        munmap(dados, col->tamanho);
+        col->dados = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+// lerBlocoColuna():
+// Lê o cabeçalho do próximo bloco e aponta 'valores' para os dados dele, avançando a posição.
+// Retorna 0 no fim do arquivo (um bloco final incompleto, de uma gravação interrompida, também conta como fim).
+static int lerBlocoColuna(ColunaMapeada *col, CabecalhoBloco *bloco, const void **valores) {
+    if (col->tamanho - col->posicao < sizeof(CabecalhoBloco)) return 0;
+    memcpy(bloco, col->dados + col->posicao, sizeof(*bloco));
+    size_t bytes = (size_t)bloco->linhas * col->cabecalho.bytesValor;
+    if (bloco->linhas > LINHAS_BLOCO_COLUNA || col->tamanho - col->posicao - sizeof(CabecalhoBloco) < bytes) return 0;
+    *valores = col->dados + col->posicao + sizeof(CabecalhoBloco);
+    col->posicao += sizeof(CabecalhoBloco) + bytes;
+    return 1;
+}
+
+// blocoForaDoFiltro() / blocoDentroDoFiltro():
+// Pelo mínimo e o máximo do bloco: nenhuma linha passa no filtro / todas passam (o filtro nem precisa rodar).
+static int blocoForaDoFiltro(const FiltroConsulta *f, const CabecalhoBloco *b, uint32_t bytesValor) {
+    if (bytesValor == 8) return b->maximo < f->minimo || b->minimo > f->maximo;
+    return (int64_t)b->maximo < (int64_t)f->minimo || (int64_t)b->minimo > (int64_t)f->maximo;
+}
+
+static int blocoDentroDoFiltro(const FiltroConsulta *f, const CabecalhoBloco *b, uint32_t bytesValor) {
+    if (bytesValor == 8) return b->minimo >= f->minimo && b->maximo <= f->maximo;
+    return (int64_t)b->minimo >= (int64_t)f->minimo && (int64_t)b->maximo <= (int64_t)f->maximo;
+}
+
+// aplicarFiltro():
+// Zera em 'selecao' (máscaras: -1 = linha aceita) as linhas fora do filtro, sem desvios. Nas colunas de 4 bytes
+// quatro linhas são comparadas por vez com os vetores do GCC (uma instrução SSE/NEON por comparação); a coluna
+// de sementes (8 bytes sem sinal, sem comparação vetorial no SSE2) usa o mesmo laço em escalar.
+static void aplicarFiltro(int32_t *restrict selecao, const void *valores, uint32_t linhas, const FiltroConsulta *f,
+                          uint32_t bytesValor) {
+    uint32_t i = 0;
+    if (bytesValor == 8) {
+        const uint64_t *restrict v = (const uint64_t *)valores;
+        for (; i < linhas; ++i) selecao[i] &= -(int32_t)((v[i] >= f->minimo) & (v[i] <= f->maximo));
+        return;
+    }
+    const int32_t *restrict v = (const int32_t *)valores;
+    int32_t minimo = (int32_t)(int64_t)f->minimo, maximo = (int32_t)(int64_t)f->maximo;
+    VetorInt32 vetorMinimo = (VetorInt32){0} + minimo, vetorMaximo = (VetorInt32){0} + maximo;
+    for (; i + 4 <= linhas; i += 4) {
+        VetorInt32 x, aceitas;
+        memcpy(&x, v + i, sizeof(x));
+        memcpy(&aceitas, selecao + i, sizeof(aceitas));
+        aceitas &= (x >= vetorMinimo) & (x <= vetorMaximo);
+        memcpy(selecao + i, &aceitas, sizeof(aceitas));
+    }
+    for (; i < linhas; ++i) selecao[i] &= -(int32_t)((v[i] >= minimo) & (v[i] <= maximo));
+}
+
+// lerFaixaConsulta():
+// Lê "N" ou "A-B" (inteiros com sinal, ou sem sinal se 'semSinal') nos limites de um filtro. Retorna 0 se inválido.
+static int lerFaixaConsulta(const char *texto, int semSinal, FiltroConsulta *f) {
+    char *fim;
+    if (semSinal) {
+        f->minimo = f->maximo = strtoull(texto, &fim, 10);
+        if (*fim == '-') f->maximo = strtoull(fim + 1, &fim, 10);
+        return *fim == '\0' && f->minimo <= f->maximo;
+    }
+    long long a = strtoll(texto, &fim, 10), b = a;
+    if (*fim == '-' && fim != texto) b = strtoll(fim + 1, &fim, 10);
+    if (*fim != '\0' || a > b || a < INT32_MIN || b > INT32_MAX) return 0;
+    f->minimo = (uint64_t)(int64_t)a;
+    f->maximo = (uint64_t)(int64_t)b;
+    return 1;
+}
+
+// executarConsulta():
+// Subcomando "consultar": lê a exportação colunar do simulador (war simular --colunas) sem carregá-la, mapeando na
+// memória só as colunas usadas. Filtra por vencedor, missão, tipo de missão, cópia antitética e faixas de semente,
+// rodadas ou blitz; agrupa (--agrupar) por vencedor, missão, tipo, rodadas, blitz ou cópia antitética; e dá, por grupo, a contagem, a fração, a média e
+// os percentis 50/90/99 da coluna medida (--medir rodadas|blitz). Blocos cujo mínimo e máximo ficam fora de algum
+// filtro são pulados sem ler os valores; nos demais, cada filtro marca as linhas aceitas com comparações SIMD.
+int executarConsulta(int argc, char *argv[]) {
+    static const char *nomesTipos[MISSAO_OCUPAR + 1] = {"destruir", "territorios", "continentes", "ocupar"};
+    FiltroConsulta filtros[TOTAL_COLUNAS];
+    int totalFiltros = 0, agrupar = -1, medir = COLUNA_RODADAS;
+    const char *diretorio = argc > 1 && argv[1][0] != '-' ? argv[1] : NULL;
+    for (int i = 2; diretorio != NULL && i < argc; ++i) {
+        int coluna = -1;
+        if (i + 1 < argc && strncmp(argv[i], "--", 2) == 0) {
+            for (int c = 0; c < TOTAL_COLUNAS; ++c) {
+                if (c != COLUNA_TERRITORIOS && strcmp(argv[i] + 2, nomesColunas[c]) == 0) coluna = c;
+            }
+            if (strcmp(argv[i], "--sementes") == 0) coluna = COLUNA_SEMENTE;
+        }
+        if (coluna >= 0) {
+            FiltroConsulta *f = &filtros[totalFiltros];
+            f->coluna = coluna;
+            const char *valor = argv[++i];
+            int ok = 0;
+            for (int t = 0; coluna == COLUNA_TIPO && t <= MISSAO_OCUPAR; ++t) {
+                if (strcmp(valor, nomesTipos[t]) == 0) {
+                    f->minimo = f->maximo = (uint64_t)t;
+                    ok = 1;
+                }
+            }
+            if (!ok && !lerFaixaConsulta(valor, coluna == COLUNA_SEMENTE, f)) {
+                fprintf(stderr, "Erro: valor inválido para %s: '%s'.\n", argv[i - 1], valor);
+                return EXIT_FAILURE;
+            }
+            // um segundo filtro na mesma coluna substitui o primeiro
+            int repetido = 0;
+            for (int k = 0; k < totalFiltros; ++k) {
+                if (filtros[k].coluna == coluna) {
+                    filtros[k] = *f;
+                    repetido = 1;
+                }
+            }
+            totalFiltros += !repetido;
+        } else if ((strcmp(argv[i], "--agrupar") == 0 || strcmp(argv[i], "--medir") == 0) && i + 1 < argc) {
+            int *destino = strcmp(argv[i], "--agrupar") == 0 ? &agrupar : &medir;
+            *destino = -1;
+            for (int c = COLUNA_VENCEDOR; c <= COLUNA_ANTITETICA; ++c) {
+                if (strcmp(argv[i + 1], nomesColunas[c]) == 0) *destino = c;
+            }
+            if (*destino < 0 || (destino == &medir && medir != COLUNA_RODADAS && medir != COLUNA_BLITZ)) {
+                fprintf(stderr, "Erro: coluna inválida para %s: '%s'.\n", argv[i], argv[i + 1]);
+                return EXIT_FAILURE;
+            }
+            ++i;
+        } else {
+            diretorio = NULL;
+        }
+    }
+    if (diretorio == NULL) {
+        fprintf(stderr, "Uso: war consultar DIRETORIO [--vencedor N] [--missao N] [--tipo destruir|territorios|continentes|ocupar]\n"
+                        "                  [--sementes A-B] [--rodadas A-B] [--blitz A-B] [--antitetica 0|1]\n"
+                        "                  [--agrupar vencedor|missao|tipo|rodadas|blitz|antitetica] [--medir rodadas|blitz]\n"
+                        "Faixas são \"N\" ou \"A-B\"; DIRETORIO é o de 'war simular --colunas'.\n");
+        return EXIT_FAILURE;
+    }
+
+    int usada[TOTAL_COLUNAS] = {0};
+    for (int k = 0; k < totalFiltros; ++k) usada[filtros[k].coluna] = 1;
+    if (agrupar >= 0) usada[agrupar] = 1;
+    usada[medir] = 1;
+    ColunaMapeada colunas[TOTAL_COLUNAS] = {{0}};
+    GrupoConsulta *grupos = NULL;
+    size_t totalGrupos = 1;
+    int32_t *selecao = (int32_t *)malloc(LINHAS_BLOCO_COLUNA * sizeof(int32_t));
+    int codigo = EXIT_FAILURE;
+    if (selecao == NULL) {
+        fprintf(stderr, "Erro: memória insuficiente para a consulta.\n");
+        goto fim;
+    }
+    for (int c = 0; c < TOTAL_COLUNAS; ++c) {
+        if (usada[c] && !mapearColuna(diretorio, c, &colunas[c])) {
+            fprintf(stderr, "Erro: '%s/%s.col' não existe ou não é uma coluna da exportação do simulador.\n", diretorio,
+                    nomesColunas[c]);
+            goto fim;
+        }
+    }
+
+    // faixa da coluna agrupada pelos cabeçalhos de bloco: um grupo por valor possível
+    int64_t menorChave = 0, maiorChave = 0;
+    if (agrupar >= 0) {
+        ColunaMapeada varredura = colunas[agrupar];
+        CabecalhoBloco bloco;
+        const void *valores;
+        int primeiro = 1;
+        while (lerBlocoColuna(&varredura, &bloco, &valores)) {
+            if (primeiro || (int64_t)bloco.minimo < menorChave) menorChave = (int64_t)bloco.minimo;
+            if (primeiro || (int64_t)bloco.maximo > maiorChave) maiorChave = (int64_t)bloco.maximo;
+            primeiro = 0;
+        }
+        if (maiorChave - menorChave >= MAX_GRUPOS_CONSULTA) {
+            fprintf(stderr, "Erro: a coluna '%s' tem valores demais para agrupar (mais de %d).\n", nomesColunas[agrupar],
+                    MAX_GRUPOS_CONSULTA);
+            goto fim;
+        }
+    }
+    totalGrupos = (size_t)(maiorChave - menorChave + 1);
+    grupos = (GrupoConsulta *)calloc(totalGrupos, sizeof(GrupoConsulta));
+    if (grupos == NULL) {
+        fprintf(stderr, "Erro: memória insuficiente para a consulta.\n");
+        goto fim;
+    }
+
+    long long partidas = 0, aceitas = 0, blocos = 0, pulados = 0;
+    for (;;) {
+        CabecalhoBloco bloco[TOTAL_COLUNAS];
+        const void *valores[TOTAL_COLUNAS] = {NULL};
+        int fimDados = 0, linhas = -1;
+        for (int c = 0; c < TOTAL_COLUNAS; ++c) {
+            if (!usada[c]) continue;
+            if (!lerBlocoColuna(&colunas[c], &bloco[c], &valores[c])) fimDados = 1;
+            else if (linhas >= 0 && (int)bloco[c].linhas != linhas) fimDados = -1;
+            else linhas = (int)bloco[c].linhas;
+        }
+        if (fimDados < 0) {
+            fprintf(stderr, "Erro: as colunas de '%s' não têm os mesmos blocos.\n", diretorio);
+            goto fim;
+        }
+        if (fimDados) break;
+        blocos++;
+        partidas += linhas;
+        int pular = 0, todas = 1;
+        for (int k = 0; k < totalFiltros; ++k) {
+            const FiltroConsulta *f = &filtros[k];
+            uint32_t bytesValor = colunas[f->coluna].cabecalho.bytesValor;
+            pular |= blocoForaDoFiltro(f, &bloco[f->coluna], bytesValor);
+            todas &= blocoDentroDoFiltro(f, &bloco[f->coluna], bytesValor);
+        }
+        if (pular) {
+            pulados++;
+            continue;
+        }
+        memset(selecao, 0xFF, (size_t)linhas * sizeof(int32_t));
+        for (int k = 0; k < totalFiltros && !todas; ++k) {
+            const FiltroConsulta *f = &filtros[k];
+            aplicarFiltro(selecao, valores[f->coluna], (uint32_t)linhas, f, colunas[f->coluna].cabecalho.bytesValor);
+        }
+        const int32_t *chave = agrupar >= 0 ? (const int32_t *)valores[agrupar] : NULL;
+        const int32_t *medida = (const int32_t *)valores[medir];
+        for (int i = 0; i < linhas; ++i) {
+            if (!selecao[i]) continue;
+            GrupoConsulta *g = &grupos[chave != NULL ? chave[i] - menorChave : 0];
+            if (g->medida == NULL && (g->medida = (HistogramaHDR *)calloc(1, sizeof(HistogramaHDR))) == NULL) {
+                fprintf(stderr, "Erro: memória insuficiente para a consulta.\n");
+                goto fim;
+            }
+            g->partidas++;
+            g->soma += medida[i];
+            registrarHDR(g->medida, medida[i]);
+            aceitas++;
+        }
+    }
+
+    printf("Consulta em '%s': %lld partida(s) em %lld bloco(s), %lld bloco(s) pulado(s) pelo mínimo/máximo\n",
+           diretorio, partidas, blocos, pulados);
+    printf("Aceitas pelos filtros: %lld partida(s)\n", aceitas);
+    // larguras em bytes: 'ç', 'ã' e 'é' ocupam dois bytes cada
+    printf("%-16s %10s %10s %11s %8s %8s %8s   (%s)\n", agrupar >= 0 ? nomesColunas[agrupar] : "grupo", "partidas",
+           "fração", "média", "p50", "p90", "p99", nomesColunas[medir]);
+    for (size_t k = 0; k < totalGrupos; ++k) {
+        const GrupoConsulta *g = &grupos[k];
+        if (g->partidas == 0) continue;
+        long long valor = menorChave + (long long)k;
+        char rotulo[TAM_COR + 16];
+        if (agrupar < 0) {
+            snprintf(rotulo, sizeof(rotulo), "todas");
+        } else if ((agrupar == COLUNA_VENCEDOR || agrupar == COLUNA_MISSAO || agrupar == COLUNA_TIPO) && valor < 0) {
+            snprintf(rotulo, sizeof(rotulo), "sem vencedor");
+        } else if (agrupar == COLUNA_VENCEDOR && valor < MAX_JOGADORES) {
+            nomearJogador((int)valor, rotulo, sizeof(rotulo));
+        } else if (agrupar == COLUNA_TIPO && valor <= MISSAO_OCUPAR) {
+            snprintf(rotulo, sizeof(rotulo), "%s", nomesTipos[valor]);
+        } else {
+            snprintf(rotulo, sizeof(rotulo), "%lld", valor);
+        }
+        int visiveis = 0; // rótulos como "Exército 6" têm caracteres de dois bytes
+        for (const char *p = rotulo; *p != '\0'; ++p) visiveis += (*p & 0xC0) != 0x80;
+        printf("%s%*s %10lld %7.2f%% %10.2f %8u %8u %8u\n", rotulo, visiveis < 16 ? 16 - visiveis : 0, "", g->partidas,
+               100.0 * (double)g->partidas / (double)aceitas, g->soma / (double)g->partidas,
+               quantilHDR(g->medida, 0.5), quantilHDR(g->medida, 0.9), quantilHDR(g->medida, 0.99));
+    }
+    codigo = EXIT_SUCCESS;
+fim:
+    for (size_t k = 0; grupos != NULL && k < totalGrupos; ++k) free(grupos[k].medida);
+    free(grupos);
+    free(selecao);
+    for (int c = 0; c < TOTAL_COLUNAS; ++c) {
+        if (colunas[c].dados != NULL) munmap((void *)colunas[c].dados, colunas[c].tamanho);
+    }
+    return codigo;
+}
+
+// Varredura de parâmetros: as configurações iniciais e, para cada item (configuração, partida), o vencedor e o
+// tipo da missão dele. Cada item é uma tarefa paralela independente com a própria partida; a partida 'p' de
+// toda configuração usa a semente base + p (números aleatórios comuns entre configurações).
+typedef struct {
+    const Regras *regras;
+    const ConfiguracaoInicial *configs;
+    int partidas;
+    int limiteRodadas;
+    uint64_t semente;
+    signed char *vencedor;   // [config * partidas + p]: ID do vencedor (-1 = sem vencedor, -2 = erro)
+    signed char *tipo;       // tipo da missão do vencedor
+} ContextoVarredura;
+
+// lerFaixaTropas():
+// Lê "N" ou "A-B" (tropas >= 1) em 'faixa'. Retorna 0 se o texto for inválido.
+static int lerFaixaTropas(const char *texto, int faixa[2]) {
+    char *fim;
+    long a = strtol(texto, &fim, 10), b = a;
+    if (*fim == '-') b = strtol(fim + 1, &fim, 10);
+    if (*fim != '\0' || a < 1 || b < a || b > INT32_MAX / 2) return 0;
+    faixa[0] = (int)a;
+    faixa[1] = (int)b;
+    return 1;
+}
+
+// lerFaixasTropas():
+// Lê --tropas: uma faixa para todos os territórios ("3-8") ou uma por território, separadas por vírgula
+// ("5,4,3-8,3,5"). Retorna 0 se o texto for inválido.
+static int lerFaixasTropas(const char *texto, int faixas[TOTAL_TERRITORIOS][2]) {
+    char copia[TAM_LINHA];
+    snprintf(copia, sizeof(copia), "%s", texto);
+    char *partes[TOTAL_TERRITORIOS + 1];
+    int total = 0;
+    for (char *p = strtok(copia, ","); p != NULL && total <= TOTAL_TERRITORIOS; p = strtok(NULL, ",")) partes[total++] = p;
+    if (total != 1 && total != TOTAL_TERRITORIOS) return 0;
+    for (int i = 0; i < TOTAL_TERRITORIOS; ++i) {
+        if (!lerFaixaTropas(partes[total == 1 ? 0 : i], faixas[i])) return 0;
+    }
+    return 1;
+}
+
+// lerDonos():
+// Lê uma distribuição de donos ("0,1,2,3,4"): precisa dar ao menos um território a cada exército do mapa padrão.
+// Retorna 0 se o texto for inválido.
+static int lerDonos(const char *texto, int donos[TOTAL_TERRITORIOS]) {
+    int usados[TOTAL_JOGADORES] = {0};
+    const char *p = texto;
+    for (int i = 0; i < TOTAL_TERRITORIOS; ++i) {
+        char *fim;
+        long dono = strtol(p, &fim, 10);
+        if (fim == p || dono < 0 || dono >= TOTAL_JOGADORES || *fim != (i + 1 < TOTAL_TERRITORIOS ? ',' : '\0')) return 0;
+        donos[i] = (int)dono;
+        usados[dono] = 1;
+        p = fim + 1;
+    }
+    for (int j = 0; j < TOTAL_JOGADORES; ++j) {
+        if (!usados[j]) return 0;
+    }
+    return 1;
+}
+
+// gerarPermutacoesDonos():
+// Preenche 'donos' com todas as distribuições válidas do mapa padrão (as permutações dos exércitos, em ordem
+// lexicográfica). Retorna quantas foram geradas.
+static int gerarPermutacoesDonos(int (*donos)[TOTAL_TERRITORIOS]) {
+    int atual[TOTAL_TERRITORIOS];
+    for (int i = 0; i < TOTAL_TERRITORIOS; ++i) atual[i] = i;
+    int total = 0;
+    for (;;) {
+        memcpy(donos[total++], atual, sizeof(atual));
+        // próxima permutação lexicográfica
+        int i = TOTAL_TERRITORIOS - 2;
+        while (i >= 0 && atual[i] > atual[i + 1]) --i;
+        if (i < 0) return total;
+        int j = TOTAL_TERRITORIOS - 1;
+        while (atual[j] < atual[i]) --j;
+        int t = atual[i]; atual[i] = atual[j]; atual[j] = t;
+        for (int a = i + 1, b = TOTAL_TERRITORIOS - 1; a < b; ++a, --b) {
+            t = atual[a]; atual[a] = atual[b]; atual[b] = t;
+        }
+    }
+}
+
+// calcularDesequilibrio():
+// Medida de desequilíbrio de uma configuração: diferença entre a maior e a menor taxa de vitória dos exércitos
+// somada à taxa de partidas sem vencedor (um mapa que sempre empata não é equilibrado). 0 = perfeitamente justo.
+static double calcularDesequilibrio(const int *vitorias, int jogadores, int empates, int partidas) {
+    int minimo = vitorias[0], maximo = vitorias[0];
+    for (int j = 1; j < jogadores; ++j) {
+        if (vitorias[j] < minimo) minimo = vitorias[j];
+        if (vitorias[j] > maximo) maximo = vitorias[j];
+    }
+    return partidas > 0 ? (double)(maximo - minimo + empates) / partidas : 1.0;
+}
+
+// simularItemVarredura():
+// Tarefa paralela: joga a partida 'indice % partidas' da configuração 'indice / partidas'.
+static void simularItemVarredura(void *contexto, size_t indice) {
+    ContextoVarredura *ctx = (ContextoVarredura *)contexto;
+    size_t config = indice / (size_t)ctx->partidas, partida = indice % (size_t)ctx->partidas;
+    Jogo jogo;
+    ctx->vencedor[indice] = -2;
+    if (!criarJogoConfigurado(&jogo, ctx->regras, ctx->semente + partida, &ctx->configs[config])) return;
+    int vencedor = simularPartida(&jogo, ctx->limiteRodadas);
+    ctx->vencedor[indice] = (signed char)vencedor;
+    ctx->tipo[indice] = vencedor >= 0 ? (signed char)jogo.catalogo[jogo.missoes[vencedor].id].tipo : -1;
+    liberarMemoria(&jogo);
+}
+
+// executarVarredura():
+// Subcomando "varrer": roda a grade completa (ou uma amostra em hipercubo latino, com --lhs N) de configurações
+// iniciais do mapa padrão — faixas de tropas por território (--tropas) e distribuições de donos (--donos,
+// repetível, ou "todas") — pelo simulador paralelo e escreve, em CSV, a taxa de vitória de cada tipo de missão
+// e de cada exército por configuração (a superfície de vitórias). Sem --saida o CSV vai para a saída padrão;
+// com --saida, a saída padrão recebe um resumo com as configurações mais equilibradas.
+int executarVarredura(int argc, char *argv[]) {
+    Regras regras = variantesRegras[0];
+    int faixas[TOTAL_TERRITORIOS][2];
+    int (*donos)[TOTAL_TERRITORIOS] = (int (*)[TOTAL_TERRITORIOS])malloc(PERMUTACOES_DONOS * sizeof(*donos));
+    int totalDonos = 0, todosDonos = 0;
+    int partidas = PARTIDAS_VARREDURA, limiteRodadas = RODADAS_SIMULACAO, amostrasLhs = 0;
+    uint64_t semente = (uint64_t)time(NULL);
+    const char *saida = NULL;
+    if (donos == NULL) {
+        fprintf(stderr, "Erro: memória insuficiente.\n");
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < TOTAL_TERRITORIOS; ++i) faixas[i][0] = faixas[i][1] = configuracaoPadrao.tropas[i];
+    for (int i = 1; i < argc; ++i) {
+        int lida = lerOpcaoRegras(argc, argv, &i, &regras);
+        if (lida < 0) {
+            free(donos);
+            return EXIT_FAILURE;
+        }
+        if (lida > 0) continue;
+        int valida = 1;
+        if (strcmp(argv[i], "--tropas") == 0 && i + 1 < argc) {
+            valida = lerFaixasTropas(argv[++i], faixas);
+        } else if (strcmp(argv[i], "--donos") == 0 && i + 1 < argc) {
+            if (strcmp(argv[++i], "todas") == 0) {
+                todosDonos = 1;
+            } else {
+                valida = totalDonos < PERMUTACOES_DONOS && lerDonos(argv[i], donos[totalDonos]);
+                totalDonos += valida;
+            }
+        } else if (strcmp(argv[i], "--lhs") == 0 && i + 1 < argc) {
+            valida = (amostrasLhs = atoi(argv[++i])) > 0;
+        } else if (strcmp(argv[i], "--partidas") == 0 && i + 1 < argc) {
+            valida = (partidas = atoi(argv[++i])) > 0;
+        } else if (strcmp(argv[i], "--rodadas") == 0 && i + 1 < argc) {
+            valida = (limiteRodadas = atoi(argv[++i])) > 0;
+        } else if (strcmp(argv[i], "--semente") == 0 && i + 1 < argc) {
+            semente = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--saida") == 0 && i + 1 < argc) {
+            saida = argv[++i];
+        } else {
+            valida = 0;
+        }
+        if (!valida) {
+            fprintf(stderr, "Uso: war varrer [--tropas N|A-B|lista por território, ex.: 5,4,3-8,3,5]\n"
+                            "                [--donos 0,1,2,3,4 (repetível)|todas] [--lhs N] [--partidas N]\n"
+                            "                [--rodadas N] [--semente N] [--saida arquivo.csv] [opções de regras] [--threads N]\n");
+            free(donos);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!prepararRegras(&regras)) {
+        fprintf(stderr, "Erro: combinação de regras inválida (dados entre 1 e %d, mínimo na conquista >= 1).\n", MAX_DADOS);
+        free(donos);
+        return EXIT_FAILURE;
+    }
+    if (todosDonos) {
+        totalDonos = gerarPermutacoesDonos(donos);
+    } else if (totalDonos == 0) {
+        memcpy(donos[0], configuracaoPadrao.donos, sizeof(donos[0]));
+        totalDonos = 1;
+    }
+
+    // grade: produto das faixas de tropas e das distribuições de donos (raiz mista, donos no dígito mais lento)
+    double tamanhoGrade = totalDonos;
+    for (int i = 0; i < TOTAL_TERRITORIOS; ++i) tamanhoGrade *= faixas[i][1] - faixas[i][0] + 1;
+    size_t totalConfigs = amostrasLhs > 0 ? (size_t)amostrasLhs : (size_t)tamanhoGrade;
+    if ((amostrasLhs == 0 && tamanhoGrade > MAX_CONFIGURACOES_VARREDURA) || totalConfigs > MAX_CONFIGURACOES_VARREDURA) {
+        fprintf(stderr, "Erro: %.0f configurações passam do limite de %d; use faixas menores ou --lhs N.\n",
+                amostrasLhs > 0 ? (double)amostrasLhs : tamanhoGrade, MAX_CONFIGURACOES_VARREDURA);
+        free(donos);
+        return EXIT_FAILURE;
+    }
+    size_t totalItens = totalConfigs * (size_t)partidas;
+    ConfiguracaoInicial *configs = (ConfiguracaoInicial *)calloc(totalConfigs, sizeof(ConfiguracaoInicial));
+    signed char *vencedor = (signed char *)malloc(totalItens);
+    signed char *tipo = (signed char *)malloc(totalItens);
+    int *permutacao = (int *)malloc(totalConfigs * sizeof(int));
+    FILE *csv = saida != NULL ? fopen(saida, "w") : stdout;
+    if (configs == NULL || vencedor == NULL || tipo == NULL || permutacao == NULL || csv == NULL) {
+        fprintf(stderr, csv == NULL ? "Erro: não foi possível criar '%s'.\n" : "Erro: memória insuficiente.\n", saida);
+        if (csv != NULL && csv != stdout) fclose(csv);
+        free(configs); free(vencedor); free(tipo); free(permutacao); free(donos);
+        return EXIT_FAILURE;
+    }
+
+    if (amostrasLhs > 0) {
+        // hipercubo latino: cada dimensão (tropas de cada território e donos) é dividida em N faixas iguais
+        // e cada faixa recebe exatamente uma amostra, em ordem embaralhada
+        GeradorAleatorio rng;
+        semearGerador(&rng, semente);
+        for (int dim = 0; dim <= TOTAL_TERRITORIOS; ++dim) {
+            int base = dim < TOTAL_TERRITORIOS ? faixas[dim][0] : 0;
+            double largura = dim < TOTAL_TERRITORIOS ? faixas[dim][1] - faixas[dim][0] + 1 : totalDonos;
+            for (size_t k = 0; k < totalConfigs; ++k) permutacao[k] = (int)k;
+            for (size_t k = totalConfigs; k > 1; --k) {
+                size_t r = sortearIntervalo(&rng, (uint32_t)k);
+                int t = permutacao[k - 1]; permutacao[k - 1] = permutacao[r]; permutacao[r] = t;
+            }
+            for (size_t k = 0; k < totalConfigs; ++k) {
+                double u = (double)(proximoAleatorio(&rng) >> 11) * 0x1p-53;
+                int valor = base + (int)((permutacao[k] + u) * largura / (double)totalConfigs);
+                if (dim < TOTAL_TERRITORIOS) {
+                    configs[k].tropas[dim] = valor;
+                } else {
+                    memcpy(configs[k].donos, donos[valor], sizeof(configs[k].donos));
+                }
+            }
+        }
+    } else {
+        for (size_t k = 0; k < totalConfigs; ++k) {
+            size_t resto = k;
+            for (int i = TOTAL_TERRITORIOS - 1; i >= 0; --i) {
+                size_t largura = (size_t)(faixas[i][1] - faixas[i][0] + 1);
+                configs[k].tropas[i] = faixas[i][0] + (int)(resto % largura);
+                resto /= largura;
+            }
+            memcpy(configs[k].donos, donos[resto], sizeof(configs[k].donos));
+        }
+    }
+
+    ContextoVarredura ctx = {&regras, configs, partidas, limiteRodadas, semente, vencedor, tipo};
+    executarEmParalelo(totalItens, simularItemVarredura, &ctx);
+
+    static const char *colunasTipos[MISSAO_OCUPAR + 1] = {"destruir", "territorios", "continentes", "ocupar"};
+    fprintf(csv, "configuracao");
+    for (int i = 0; i < TOTAL_TERRITORIOS; ++i) {
+        fprintf(csv, ",tropas_");
+        for (const char *c = nomesTerritorios[i]; *c != '\0'; ++c) fputc(*c == ' ' ? '_' : *c, csv);
+    }
+    fprintf(csv, ",donos,partidas");
+    for (int t = 0; t <= MISSAO_OCUPAR; ++t) fprintf(csv, ",%s", colunasTipos[t]);
+    fprintf(csv, ",sem_vencedor");
+    for (int j = 0; j < TOTAL_JOGADORES; ++j) fprintf(csv, ",%s", nomesExercitos[j]);
+    fprintf(csv, "\n");
+
+    size_t melhores[3] = {SIZE_MAX, SIZE_MAX, SIZE_MAX};
+    double espalhamento[3] = {0.0, 0.0, 0.0};
+    int erros = 0;
+    for (size_t k = 0; k < totalConfigs; ++k) {
+        int porTipo[MISSAO_OCUPAR + 1] = {0}, porJogador[TOTAL_JOGADORES] = {0}, empates = 0;
+        for (int p = 0; p < partidas; ++p) {
+            size_t item = k * (size_t)partidas + (size_t)p;
+            if (vencedor[item] == -2) {
+                erros++;
+            } else if (vencedor[item] < 0) {
+                empates++;
+            } else {
+                porJogador[vencedor[item]]++;
+                porTipo[tipo[item]]++;
+            }
+        }
+        fprintf(csv, "%zu", k + 1);
+        for (int i = 0; i < TOTAL_TERRITORIOS; ++i) fprintf(csv, ",%d", configs[k].tropas[i]);
+        fprintf(csv, ",");
+        for (int i = 0; i < TOTAL_TERRITORIOS; ++i) fprintf(csv, "%s%d", i > 0 ? "-" : "", configs[k].donos[i]);
+        fprintf(csv, ",%d", partidas);
+        for (int t = 0; t <= MISSAO_OCUPAR; ++t) fprintf(csv, ",%.4f", (double)porTipo[t] / partidas);
+        fprintf(csv, ",%.4f", (double)empates / partidas);
+        for (int j = 0; j < TOTAL_JOGADORES; ++j) fprintf(csv, ",%.4f", (double)porJogador[j] / partidas);
+        fprintf(csv, "\n");
+        // guarda as três configurações mais equilibradas
+        double e = calcularDesequilibrio(porJogador, TOTAL_JOGADORES, empates, partidas);
+        for (int m = 0; m < 3; ++m) {
+            if (melhores[m] == SIZE_MAX || e < espalhamento[m]) {
+                for (int n = 2; n > m; --n) {
+                    melhores[n] = melhores[n - 1];
+                    espalhamento[n] = espalhamento[n - 1];
+                }
+                melhores[m] = k;
+                espalhamento[m] = e;
+                break;
+            }
+        }
+    }
+
+    int status = EXIT_SUCCESS;
+    if (csv != stdout && fclose(csv) != 0) {
+        fprintf(stderr, "Erro: falha ao gravar '%s'.\n", saida);
+        status = EXIT_FAILURE;
+    }
+    if (erros > 0) {
+        fprintf(stderr, "Erro: %d partida(s) não puderam ser criadas (memória insuficiente).\n", erros);
+        status = EXIT_FAILURE;
+    }
+    if (saida != NULL && status == EXIT_SUCCESS) {
+        printf("=== Varredura: %zu configuração(ões) %s, %d partida(s) cada, regras %s -> %s ===\n", totalConfigs,
+               amostrasLhs > 0 ? "(hipercubo latino)" : "(grade completa)", partidas, regras.nome, saida);
+        printf("Mais equilibradas (diferença entre a maior e a menor taxa de vitória + partidas sem vencedor):\n");
+        for (int m = 0; m < 3 && melhores[m] != SIZE_MAX; ++m) {
+            const ConfiguracaoInicial *c = &configs[melhores[m]];
+            printf("  #%zu tropas", melhores[m] + 1);
+            for (int i = 0; i < TOTAL_TERRITORIOS; ++i) printf(" %d", c->tropas[i]);
+            printf(" | donos");
+            for (int i = 0; i < TOTAL_TERRITORIOS; ++i) printf(" %s", nomesExercitos[c->donos[i]]);
+            printf(" | desequilíbrio %.1f%%\n", 100.0 * espalhamento[m]);
+        }
+    }
+    free(configs);
+    free(vencedor);
+    free(tipo);
+    free(permutacao);
+    free(donos);
+    return status;
+}
+
+// Candidato de um passo do balanceador, com as vitórias acumuladas nas partidas já jogadas por ele.
+typedef struct {
+    ConfiguracaoInicial config;
+    int vitorias[TOTAL_JOGADORES];
+    int empates;
+    int partidas;
+    int ativo;                  // 0 = eliminado na corrida
+} CandidatoBalanceamento;
+
+// imprimirConfiguracao():
+// Mostra tropas e donos de uma configuração no formato de inicialização de configuracaoPadrao.
+static void imprimirConfiguracao(const ConfiguracaoInicial *config) {
+    printf("{{");
+    for (int i = 0; i < TOTAL_TERRITORIOS; ++i) printf("%s%d", i > 0 ? ", " : "", config->tropas[i]);
+    printf("}, {");
+    for (int i = 0; i < TOTAL_TERRITORIOS; ++i) printf("%s%d", i > 0 ? ", " : "", config->donos[i]);
+    printf("}}");
+}
+
+// correrCandidatos():
+// Avalia os candidatos numa corrida com eliminação: a cada lote de LOTE_BALANCEAMENTO partidas (as mesmas
+// sementes para todos, jogadas em paralelo) descarta quem já está claramente pior que o melhor estimado
+// (margem de dois erros padrão da diferença de duas taxas, no pior caso sqrt(2 / partidas)). O candidato 0
+// (a configuração atual) nunca é descartado, para servir de referência. Para quando só ele sobra ou todos
+// jogaram 'maxPartidas'. Retorna o índice do melhor ativo (o 0 nos empates) ou -1 se faltar memória.
+static int correrCandidatos(const Regras *regras, CandidatoBalanceamento *candidatos, int total, int maxPartidas,
+                            int limiteRodadas, uint64_t semente) {
+    ConfiguracaoInicial *configs = (ConfiguracaoInicial *)malloc((size_t)total * sizeof(ConfiguracaoInicial));
+    int *indices = (int *)malloc((size_t)total * sizeof(int));
+    signed char *vencedor = (signed char *)malloc((size_t)total * LOTE_BALANCEAMENTO);
+    signed char *tipo = (signed char *)malloc((size_t)total * LOTE_BALANCEAMENTO);
+    int melhor = -1;
+    if (configs == NULL || indices == NULL || vencedor == NULL || tipo == NULL) goto fim;
+    for (int jogadas = 0; jogadas < maxPartidas;) {
+        int lote = maxPartidas - jogadas < LOTE_BALANCEAMENTO ? maxPartidas - jogadas : LOTE_BALANCEAMENTO;
+        int ativos = 0;
+        for (int c = 0; c < total; ++c) {
+            if (!candidatos[c].ativo) continue;
+            configs[ativos] = candidatos[c].config;
+            indices[ativos++] = c;
+        }
+        ContextoVarredura ctx = {regras, configs, lote, limiteRodadas, semente + (uint64_t)jogadas, vencedor, tipo};
+        executarEmParalelo((size_t)ativos * (size_t)lote, simularItemVarredura, &ctx);
+        for (int a = 0; a < ativos; ++a) {
+            CandidatoBalanceamento *c = &candidatos[indices[a]];
+            for (int p = 0; p < lote; ++p) {
+                int v = vencedor[(size_t)a * lote + p];
+                if (v == -2) {
+                    melhor = -1;
+                    goto fim;
+                }
+                if (v < 0) c->empates++; else c->vitorias[v]++;
+            }
+            c->partidas += lote;
+        }
+        jogadas += lote;
+
+        melhor = -1;
+        double menor = 0.0;
+        for (int c = 0; c < total; ++c) {
+            if (!candidatos[c].ativo) continue;
+            double d = calcularDesequilibrio(candidatos[c].vitorias, TOTAL_JOGADORES, candidatos[c].empates, jogadas);
+            if (melhor < 0 || d < menor) {
+                melhor = c;
+                menor = d;
+            }
+        }
+        double margem = sqrt(2.0 / jogadas);
+        ativos = 0;
+        for (int c = 0; c < total; ++c) {
+            if (!candidatos[c].ativo) continue;
+            double d = calcularDesequilibrio(candidatos[c].vitorias, TOTAL_JOGADORES, candidatos[c].empates, jogadas);
+            if (c > 0 && d > menor + margem) candidatos[c].ativo = 0;
+            ativos += candidatos[c].ativo;
+        }
+        if (ativos <= 1) break;
+    }
+fim:
+    free(configs);
+    free(indices);
+    free(vencedor);
+    free(tipo);
+    return melhor;
+}
+
+// executarBalanceamento():
+// Subcomando "balancear": descida por coordenadas com avaliações ruidosas a partir da configuração padrão.
+// Cada passo compara a configuração atual com as vizinhas (uma tropa a mais ou a menos em um território e,
+// sem --fixar-donos, a troca dos donos de dois territórios) numa corrida com eliminação pelo simulador
+// paralelo, e fica com a de menor desequilíbrio (calcularDesequilibrio()). Para quando o desequilíbrio fica
+// dentro da tolerância, quando nenhuma vizinha é melhor ou após --iteracoes passos. Cada passo usa sementes
+// novas, para não ajustar o mapa às mesmas partidas.
+int executarBalanceamento(int argc, char *argv[]) {
+    Regras regras = variantesRegras[0];
+    int tropasMin = 1, tropasMax = 10;
+    int maxPartidas = PARTIDAS_BALANCEAMENTO, iteracoes = ITERACOES_BALANCEAMENTO, limiteRodadas = RODADAS_SIMULACAO;
+    int fixarDonos = 0;
+    double tolerancia = TOLERANCIA_BALANCEAMENTO;
+    uint64_t semente = (uint64_t)time(NULL);
+    for (int i = 1; i < argc; ++i) {
+        int lida = lerOpcaoRegras(argc, argv, &i, &regras);
+        if (lida < 0) return EXIT_FAILURE;
+        if (lida > 0) continue;
+        int valida = 1;
+        if (strcmp(argv[i], "--tropas-min") == 0 && i + 1 < argc) {
+            valida = (tropasMin = atoi(argv[++i])) >= 1;
+        } else if (strcmp(argv[i], "--tropas-max") == 0 && i + 1 < argc) {
+            valida = (tropasMax = atoi(argv[++i])) >= 1;
+        } else if (strcmp(argv[i], "--tolerancia") == 0 && i + 1 < argc) {
+            valida = (tolerancia = strtod(argv[++i], NULL)) >= 0.0;
+        } else if (strcmp(argv[i], "--partidas") == 0 && i + 1 < argc) {
+            valida = (maxPartidas = atoi(argv[++i])) > 0;
+        } else if (strcmp(argv[i], "--iteracoes") == 0 && i + 1 < argc) {
+            valida = (iteracoes = atoi(argv[++i])) > 0;
+        } else if (strcmp(argv[i], "--rodadas") == 0 && i + 1 < argc) {
+            valida = (limiteRodadas = atoi(argv[++i])) > 0;
+        } else if (strcmp(argv[i], "--semente") == 0 && i + 1 < argc) {
+            semente = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--fixar-donos") == 0) {
+            fixarDonos = 1;
+        } else {
+            valida = 0;
+        }
+        if (!valida || tropasMin > tropasMax) {
+            fprintf(stderr, "Uso: war balancear [--tropas-min N] [--tropas-max N] [--tolerancia 0..1] [--partidas N]\n"
+                            "                   [--iteracoes N] [--rodadas N] [--semente N] [--fixar-donos]\n"
+                            "                   [opções de regras] [--threads N]\n");
+            return EXIT_FAILURE;
+        }
+    }
+    if (!prepararRegras(&regras)) {
+        fprintf(stderr, "Erro: combinação de regras inválida (dados entre 1 e %d, mínimo na conquista >= 1).\n", MAX_DADOS);
+        return EXIT_FAILURE;
+    }
+
+    // atual + uma tropa a mais/a menos por território + trocas de donos de cada par de territórios
+    enum { MAX_CANDIDATOS = 1 + 2 * TOTAL_TERRITORIOS + TOTAL_TERRITORIOS * (TOTAL_TERRITORIOS - 1) / 2 };
+    CandidatoBalanceamento candidatos[MAX_CANDIDATOS];
+    ConfiguracaoInicial atual = configuracaoPadrao;
+    for (int i = 0; i < TOTAL_TERRITORIOS; ++i) {
+        if (atual.tropas[i] < tropasMin) atual.tropas[i] = tropasMin;
+        if (atual.tropas[i] > tropasMax) atual.tropas[i] = tropasMax;
+    }
+    printf("=== Balanceamento do mapa padrão (regras %s, até %d partidas por candidato, tolerância %.1f%%) ===\n",
+           regras.nome, maxPartidas, 100.0 * tolerancia);
+    long long totalPartidas = 0;
+    double desequilibrio = 1.0;
+    CandidatoBalanceamento escolhido = {0};
+    int passo;
+    for (passo = 1; passo <= iteracoes; ++passo) {
+        int total = 0;
+        memset(candidatos, 0, sizeof(candidatos));
+        candidatos[total++].config = atual;
+        for (int i = 0; i < TOTAL_TERRITORIOS; ++i) {
+            for (int delta = -1; delta <= 1; delta += 2) {
+                int tropas = atual.tropas[i] + delta;
+                if (tropas < tropasMin || tropas > tropasMax) continue;
+                candidatos[total].config = atual;
+                candidatos[total++].config.tropas[i] = tropas;
+            }
+        }
+        for (int i = 0; !fixarDonos && i < TOTAL_TERRITORIOS; ++i) {
+            for (int k = i + 1; k < TOTAL_TERRITORIOS; ++k) {
+                if (atual.donos[i] == atual.donos[k]) continue;
+                candidatos[total].config = atual;
+                candidatos[total].config.donos[i] = atual.donos[k];
+                candidatos[total++].config.donos[k] = atual.donos[i];
+            }
+        }
+        for (int c = 0; c < total; ++c) candidatos[c].ativo = 1;
+
+        int melhor = correrCandidatos(&regras, candidatos, total, maxPartidas, limiteRodadas,
+                                      semente + (uint64_t)(passo - 1) * (uint64_t)maxPartidas);
+        if (melhor < 0) {
+            fprintf(stderr, "Erro: memória insuficiente.\n");
+            return EXIT_FAILURE;
+        }
+        for (int c = 0; c < total; ++c) totalPartidas += candidatos[c].partidas;
+        const CandidatoBalanceamento *m = &candidatos[melhor];
+        desequilibrio = calcularDesequilibrio(m->vitorias, TOTAL_JOGADORES, m->empates, m->partidas);
+        printf("Passo %d: desequilíbrio %5.1f%% em %d partida(s) | ", passo, 100.0 * desequilibrio, m->partidas);
+        imprimirConfiguracao(&m->config);
+        printf("%s\n", melhor == 0 ? " (sem vizinha melhor)" : "");
+        atual = m->config;
+        escolhido = *m;
+        if (melhor == 0 || (desequilibrio <= tolerancia && m->partidas == maxPartidas)) break;
+    }
+
+    printf("Resultado após %d passo(s) e %lld partida(s) simulada(s): desequilíbrio %.1f%% (%s)\n",
+           passo > iteracoes ? iteracoes : passo, totalPartidas, 100.0 * desequilibrio,
+           desequilibrio <= tolerancia ? "dentro da tolerância" : "acima da tolerância");
+    printf("  vitórias:");
+    for (int j = 0; j < TOTAL_JOGADORES; ++j) {
+        printf(" %s %.1f%%,", nomesExercitos[j], 100.0 * escolhido.vitorias[j] / (escolhido.partidas > 0 ? escolhido.partidas : 1));
+    }
+    printf(" sem vencedor %.1f%%\n", 100.0 * escolhido.empates / (escolhido.partidas > 0 ? escolhido.partidas : 1));
+    printf("  static const ConfiguracaoInicial configuracaoPadrao = ");
+    imprimirConfiguracao(&atual);
+    printf(";\n  tropas:");
+    for (int i = 0; i < TOTAL_TERRITORIOS; ++i) printf(" %s %d%s", nomesTerritorios[i], atual.tropas[i], i + 1 < TOTAL_TERRITORIOS ? "," : "");
+    printf("\n  donos: ");
+    for (int i = 0; i < TOTAL_TERRITORIOS; ++i) printf(" %s %s%s", nomesTerritorios[i], nomesExercitos[atual.donos[i]], i + 1 < TOTAL_TERRITORIOS ? "," : "");
+    printf("\n");
+    return EXIT_SUCCESS;
+}
+
+// Mapa de calor de conquistas: as partidas são divididas em BLOCOS_CALOR blocos fixos e cada bloco (uma tarefa
+// paralela) soma nos próprios contadores, com 'largura' = CAMPOS_CALOR + jogadores valores por território:
+// contagem[(bloco * territorios + t) * largura + campo]. No fim os blocos são somados; como as somas são inteiras,
+// o resultado não depende da ordem nem de quantas threads rodaram.
+enum {
+    CALOR_TROCAS,            // trocas de dono somadas
+    CALOR_PARTIDAS_TROCA,    // partidas em que o território trocou de dono ao menos uma vez
+    CALOR_RODADA_TOMADA,     // rodada em que o dono final tomou o território, somada nessas partidas
+    CAMPOS_CALOR             // seguido de um contador de dono final por jogador
+};
+
+typedef struct {
+    const Regras *regras;
+    size_t territorios;      // 0 = mapa padrão
+    int jogadores;
+    int partidas;
+    int limiteRodadas;
+    uint64_t semente;        // a partida 'p' joga com semente + p
+    uint64_t sementeMapa;    // o mapa (e as tropas iniciais) é o mesmo em todas as partidas
+    size_t totalTerritorios;
+    size_t largura;
+    long long *contagem;
+    int *erros;              // [bloco]: partidas que não puderam ser criadas
+} ContextoCalor;
+
+// jogarBlocoCalor():
+// Tarefa paralela: joga as partidas do bloco no mapa fixo e soma trocas de dono, rodada da tomada final e dono final
+// de cada território nos contadores do bloco.
+static void jogarBlocoCalor(void *contexto, size_t bloco) {
+    ContextoCalor *ctx = (ContextoCalor *)contexto;
+    long long *contagem = ctx->contagem + bloco * ctx->totalTerritorios * ctx->largura;
+    int inicio = (int)((long long)ctx->partidas * (long long)bloco / BLOCOS_CALOR);
+    int fim = (int)((long long)ctx->partidas * (long long)(bloco + 1) / BLOCOS_CALOR);
+    for (int p = inicio; p < fim; ++p) {
+        Jogo jogo;
+        int criado = ctx->territorios > 0 ? criarJogoGerado(&jogo, ctx->regras, ctx->sementeMapa, ctx->territorios, ctx->jogadores)
+                                          : criarJogo(&jogo, ctx->regras, ctx->sementeMapa);
+        if (!criado) {
+            ctx->erros[bloco]++;
+            continue;
+        }
+        jogo.trocasDono = (int *)alocarArena(&jogo.memoria, jogo.total, sizeof(int));
+        jogo.rodadaTroca = (int *)alocarArena(&jogo.memoria, jogo.total, sizeof(int));
+        if (jogo.trocasDono == NULL || jogo.rodadaTroca == NULL || jogo.total != ctx->totalTerritorios) {
+            ctx->erros[bloco]++;
+            liberarMemoria(&jogo);
+            continue;
+        }
+        semearGerador(&jogo.rng, ctx->semente + (uint64_t)p);
+        simularPartida(&jogo, ctx->limiteRodadas);
+        for (size_t t = 0; t < jogo.total; ++t) {
+            long long *c = contagem + t * ctx->largura;
+            c[CALOR_TROCAS] += jogo.trocasDono[t];
+            if (jogo.trocasDono[t] > 0) {
+                c[CALOR_PARTIDAS_TROCA]++;
+                c[CALOR_RODADA_TOMADA] += jogo.rodadaTroca[t];
+            }
+            c[CAMPOS_CALOR + jogo.territorios[t].dono]++;
+        }
+        liberarMemoria(&jogo);
+    }
+}
+
+// executarMapaCalor():
+// Subcomando "calor": joga N partidas automáticas no mesmo mapa (--semente-mapa; o padrão é o mapa clássico) com
+// dados e missões diferentes e escreve, em CSV, um mapa de calor por território: trocas de dono por partida,
+// fração das partidas com alguma troca, rodada média em que o dono final tomou o território e a fração das partidas
+// que cada exército terminou com ele. Territórios muito disputados são os pontos de estrangulamento do mapa.
+// Sem --saida o CSV vai para a saída padrão; com --saida, a saída padrão recebe os territórios mais disputados.
+int executarMapaCalor(int argc, char *argv[]) {
+    Regras regras = variantesRegras[0];
+    size_t territorios = 0;
+    int jogadores = 0, partidas = PARTIDAS_CALOR, limiteRodadas = RODADAS_SIMULACAO, mapaDado = 0;
+    uint64_t semente = (uint64_t)time(NULL), sementeMapa = 0;
+    const char *saida = NULL;
+    for (int i = 1; i < argc; ++i) {
+        int lida = lerOpcaoRegras(argc, argv, &i, &regras);
+        if (lida == 0) lida = lerOpcaoMapa(argc, argv, &i, &territorios, &jogadores);
+        if (lida < 0) return EXIT_FAILURE;
+        if (lida > 0) continue;
+        int valida = 1;
+        if (strcmp(argv[i], "--partidas") == 0 && i + 1 < argc) {
+            valida = (partidas = atoi(argv[++i])) > 0;
+        } else if (strcmp(argv[i], "--rodadas") == 0 && i + 1 < argc) {
+            valida = (limiteRodadas = atoi(argv[++i])) > 0;
+        } else if (strcmp(argv[i], "--semente") == 0 && i + 1 < argc) {
+            semente = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--semente-mapa") == 0 && i + 1 < argc) {
+            sementeMapa = strtoull(argv[++i], NULL, 10);
+            mapaDado = 1;
+        } else if (strcmp(argv[i], "--saida") == 0 && i + 1 < argc) {
+            saida = argv[++i];
+        } else {
+            valida = 0;
+        }
+        if (!valida) {
+            fprintf(stderr, "Uso: war calor [--territorios N (0 = mapa padrão)] [--jogadores 2..%d] [--semente-mapa N]\n"
+                            "               [--partidas N] [--rodadas N] [--semente N] [--saida arquivo.csv]\n"
+                            "               [opções de regras] [--threads N]\n", MAX_JOGADORES);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!conferirOpcaoMapa(territorios, &jogadores)) return EXIT_FAILURE;
+    if (!mapaDado) sementeMapa = semente;
+    if (!prepararRegras(&regras)) {
+        fprintf(stderr, "Erro: combinação de regras inválida (dados entre 1 e %d, mínimo na conquista >= 1).\n", MAX_DADOS);
+        return EXIT_FAILURE;
+    }
+
+    // uma cópia do mapa só para os nomes, continentes e donos iniciais
+    Jogo mapa;
+    int criado = territorios > 0 ? criarJogoGerado(&mapa, &regras, sementeMapa, territorios, jogadores)
+                                 : criarJogo(&mapa, &regras, sementeMapa);
+    if (!criado) {
+        fprintf(stderr, "Erro: não foi possível criar o mapa (2 a %d jogadores, ao menos um território por jogador).\n",
+                MAX_JOGADORES);
+        return EXIT_FAILURE;
+    }
+    size_t largura = CAMPOS_CALOR + (size_t)mapa.totalJogadores;
+    ContextoCalor ctx = {&regras, territorios, jogadores, partidas, limiteRodadas, semente, sementeMapa, mapa.total,
+                         largura, NULL, NULL};
+    ctx.contagem = (long long *)calloc(BLOCOS_CALOR * mapa.total * largura, sizeof(long long));
+    ctx.erros = (int *)calloc(BLOCOS_CALOR, sizeof(int));
+    FILE *csv = saida != NULL ? fopen(saida, "w") : stdout;
+    if (ctx.contagem == NULL || ctx.erros == NULL || csv == NULL) {
+        fprintf(stderr, csv == NULL ? "Erro: não foi possível criar '%s'.\n" : "Erro: memória insuficiente.\n", saida);
+        if (csv != NULL && csv != stdout) fclose(csv);
+        free(ctx.contagem);
+        free(ctx.erros);
+        liberarMemoria(&mapa);
+        return EXIT_FAILURE;
+    }
+
+    executarEmParalelo(BLOCOS_CALOR, jogarBlocoCalor, &ctx);
+
+    // soma os blocos no primeiro
+    int erros = ctx.erros[0];
+    for (size_t b = 1; b < BLOCOS_CALOR; ++b) {
+        const long long *c = ctx.contagem + b * mapa.total * largura;
+        for (size_t k = 0; k < mapa.total * largura; ++k) ctx.contagem[k] += c[k];
+        erros += ctx.erros[b];
+    }
+    int jogadas = partidas - erros;
+
+    fprintf(csv, "territorio,nome,continente,dono_inicial,tropas_iniciais,trocas_por_partida,partidas_com_troca,"
+                 "rodada_media_tomada");
+    for (int j = 0; j < mapa.totalJogadores; ++j) {
+        fprintf(csv, ",final_");
+        for (const char *c = mapa.nomesJogadores[j]; *c != '\0'; ++c) fputc(*c == ' ' ? '_' : *c, csv);
+    }
+    fprintf(csv, "\n");
+    for (size_t t = 0; t < mapa.total; ++t) {
+        const long long *c = ctx.contagem + t * largura;
+        const Territorio *territorio = &mapa.territorios[t];
+        fprintf(csv, "%zu,%s,%d,%s,%d,%.4f,%.4f,", t + 1, territorio->nome, territorio->continente + 1,
+                mapa.nomesJogadores[territorio->dono], territorio->tropas,
+                jogadas > 0 ? (double)c[CALOR_TROCAS] / jogadas : 0.0,
+                jogadas > 0 ? (double)c[CALOR_PARTIDAS_TROCA] / jogadas : 0.0);
+        if (c[CALOR_PARTIDAS_TROCA] > 0) fprintf(csv, "%.2f", (double)c[CALOR_RODADA_TOMADA] / c[CALOR_PARTIDAS_TROCA]);
+        for (int j = 0; j < mapa.totalJogadores; ++j) {
+            fprintf(csv, ",%.4f", jogadas > 0 ? (double)c[CAMPOS_CALOR + j] / jogadas : 0.0);
+        }
+        fprintf(csv, "\n");
+    }
+
+    int status = EXIT_SUCCESS;
+    if (csv != stdout && fclose(csv) != 0) {
+        fprintf(stderr, "Erro: falha ao gravar '%s'.\n", saida);
+        status = EXIT_FAILURE;
+    }
+    if (erros > 0) {
+        fprintf(stderr, "Erro: %d partida(s) não puderam ser criadas (memória insuficiente).\n", erros);
+        status = EXIT_FAILURE;
+    }
+    if (saida != NULL && status == EXIT_SUCCESS) {
+        printf("=== Mapa de calor: %d partida(s), %zu território(s), regras %s -> %s ===\n", jogadas, mapa.total,
+               regras.nome, saida);
+        printf("Mais disputados (trocas de dono por partida):\n");
+        size_t maisDisputados[5];
+        int total = 0;
+        for (size_t t = 0; t < mapa.total; ++t) {
+            long long trocas = ctx.contagem[t * largura + CALOR_TROCAS];
+            int pos = total < 5 ? total++ : 5;
+            while (pos > 0 && ctx.contagem[maisDisputados[pos - 1] * largura + CALOR_TROCAS] < trocas) {
+                if (pos < 5) maisDisputados[pos] = maisDisputados[pos - 1];
+                --pos;
+            }
+            if (pos < 5) maisDisputados[pos] = t;
+        }
+        for (int k = 0; k < total; ++k) {
+            size_t t = maisDisputados[k];
+            const long long *c = ctx.contagem + t * largura;
+            int dono = 0;
+            for (int j = 1; j < mapa.totalJogadores; ++j) {
+                if (c[CAMPOS_CALOR + j] > c[CAMPOS_CALOR + dono]) dono = j;
+            }
+            printf("  %-20s %6.2f troca(s) | fica com %s em %.0f%% das partidas\n", mapa.territorios[t].nome,
+                   jogadas > 0 ? (double)c[CALOR_TROCAS] / jogadas : 0.0, mapa.nomesJogadores[dono],
+                   jogadas > 0 ? 100.0 * (double)c[CAMPOS_CALOR + dono] / jogadas : 0.0);
+        }
+    }
+    free(ctx.contagem);
+    free(ctx.erros);
+    liberarMemoria(&mapa);
+    return status;
+}
+
+// Contagem de alocações do subcomando "alocacoes". Só existe no build de teste (-DCONTA_ALOCACOES=1, com a glibc
+// e sem sanitizadores, que trocam o alocador pelo deles): ali o programa substitui todas as funções de alocação
+// (malloc, calloc, realloc, reallocarray, free e as alinhadas), que repassam tudo ao alocador da glibc; enquanto a
+// contagem está ligada, cada chamada é contada e as primeiras PILHAS_ALOCACAO guardam a pilha de chamadas.
+// O build normal (jogo, "simular"...) usa o alocador da glibc sem intermediários.
+#ifndef CONTA_ALOCACOES
+#define CONTA_ALOCACOES 0
+#endif
+#if CONTA_ALOCACOES && (!defined(__GLIBC__) || defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__))
+#undef CONTA_ALOCACOES
+#define CONTA_ALOCACOES 0
+#endif
+
+static struct {
+    atomic_int ligada;
+    atomic_long alocacoes;       // malloc, calloc, realloc e as demais funções que entregam memória
+    atomic_long liberacoes;      // free de ponteiros não nulos
+    atomic_int totalPilhas;      // chamadas que tentaram guardar a pilha (só as PILHAS_ALOCACAO primeiras guardam)
+    const char *funcao[PILHAS_ALOCACAO];
+    int profundidade[PILHAS_ALOCACAO];
+    void *pilha[PILHAS_ALOCACAO][PROFUNDIDADE_PILHA];
+} contagemAlocacoes;
+
+#if CONTA_ALOCACOES
+// Marca a thread que já está registrando uma chamada (backtrace() pode alocar; essas chamadas não contam).
+static _Thread_local int registrandoAlocacao = 0;
+
+// registrarAlocacao():
+// Conta uma chamada ao alocador feita com a contagem ligada e guarda sua pilha, se ainda houver espaço.
+static void registrarAlocacao(const char *funcao, int liberacao) {
+    if (!atomic_load_explicit(&contagemAlocacoes.ligada, memory_order_relaxed) || registrandoAlocacao) return;
+    registrandoAlocacao = 1;
+    atomic_fetch_add(liberacao ? &contagemAlocacoes.liberacoes : &contagemAlocacoes.alocacoes, 1);
+    int k = atomic_fetch_add(&contagemAlocacoes.totalPilhas, 1);
+    if (k < PILHAS_ALOCACAO) {
+        contagemAlocacoes.funcao[k] = funcao;
+        contagemAlocacoes.profundidade[k] = backtrace(contagemAlocacoes.pilha[k], PROFUNDIDADE_PILHA);
+    }
+    registrandoAlocacao = 0;
+}
+
+extern void *__libc_malloc(size_t tamanho);
+extern void *__libc_calloc(size_t quantidade, size_t tamanho);
+extern void *__libc_realloc(void *ponteiro, size_t tamanho);
+extern void *__libc_memalign(size_t alinhamento, size_t tamanho);
+extern void *__libc_valloc(size_t tamanho);
+extern void *__libc_pvalloc(size_t tamanho);
+extern void __libc_free(void *ponteiro);
+void *reallocarray(void *ponteiro, size_t quantidade, size_t tamanho);
+void *memalign(size_t alinhamento, size_t tamanho);
+void *valloc(size_t tamanho);
+void *pvalloc(size_t tamanho);
+
+void *malloc(size_t tamanho) {
+    registrarAlocacao("malloc", 0);
+    return __libc_malloc(tamanho);
+}
+
+void *calloc(size_t quantidade, size_t tamanho) {
+    registrarAlocacao("calloc", 0);
+    return __libc_calloc(quantidade, tamanho);
+}
+
+void *realloc(void *ponteiro, size_t tamanho) {
+    registrarAlocacao("realloc", 0);
+    return __libc_realloc(ponteiro, tamanho);
+}
+
+void *reallocarray(void *ponteiro, size_t quantidade, size_t tamanho) {
+    registrarAlocacao("reallocarray", 0);
+    if (tamanho != 0 && quantidade > SIZE_MAX / tamanho) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return __libc_realloc(ponteiro, quantidade * tamanho);
+}
+
+void *memalign(size_t alinhamento, size_t tamanho) {
+    registrarAlocacao("memalign", 0);
+    return __libc_memalign(alinhamento, tamanho);
+}
+
+void *aligned_alloc(size_t alinhamento, size_t tamanho) {
+    registrarAlocacao("aligned_alloc", 0);
+    return __libc_memalign(alinhamento, tamanho);
+}
+
+int posix_memalign(void **ponteiro, size_t alinhamento, size_t tamanho) {
+    registrarAlocacao("posix_memalign", 0);
+    if (alinhamento < sizeof(void *) || (alinhamento & (alinhamento - 1)) != 0) return EINVAL;
+    void *bloco = __libc_memalign(alinhamento, tamanho);
+    if (bloco == NULL) return ENOMEM;
+    *ponteiro = bloco;
+    return 0;
+}
+
+void *valloc(size_t tamanho) {
+    registrarAlocacao("valloc", 0);
+    return __libc_valloc(tamanho);
+}
+
+void *pvalloc(size_t tamanho) {
+    registrarAlocacao("pvalloc", 0);
+    return __libc_pvalloc(tamanho);
+}
+
+void free(void *ponteiro) {
+    if (ponteiro != NULL) registrarAlocacao("free", 1);
+    __libc_free(ponteiro);
+}
+#endif
+
+// ligarContagemAlocacoes():
+// Zera os contadores e passa a contar (ligar = 1) ou para de contar (ligar = 0) as chamadas ao alocador.
+static void ligarContagemAlocacoes(int ligar) {
+    if (ligar) {
+        atomic_store(&contagemAlocacoes.alocacoes, 0);
+        atomic_store(&contagemAlocacoes.liberacoes, 0);
+        atomic_store(&contagemAlocacoes.totalPilhas, 0);
+    }
+    atomic_store(&contagemAlocacoes.ligada, ligar);
+}
+
+// executarVerificacaoAlocacoes():
+// Subcomando "alocacoes": monta N partidas automáticas e, só depois de cada uma estar montada, liga a contagem de
+// alocações e joga a partida inteira (simularPartida()). O laço da partida usa apenas a memória da própria partida
+// (arenas), então qualquer malloc/calloc/realloc/free ali é uma regressão: o subcomando mostra as pilhas de chamadas
+// das primeiras e termina com falha. As threads do pool são criadas antes, já que pertencem ao processo.
+// O padrão é um mapa gerado de TERRITORIOS_ALOCACOES territórios nas regras clássicas, em que as partidas duram
+// muitas rodadas e passam por reforço, planejador, cache de ameaças e remanejamento.
+int executarVerificacaoAlocacoes(int argc, char *argv[]) {
+    Regras regras = *buscarRegras("classica");
+    size_t territorios = TERRITORIOS_ALOCACOES;
+    int jogadores = 0, partidas = PARTIDAS_ALOCACOES, limiteRodadas = RODADAS_SIMULACAO;
+    uint64_t semente = (uint64_t)time(NULL);
+    for (int i = 1; i < argc; ++i) {
+        int lida = lerOpcaoRegras(argc, argv, &i, &regras);
+        if (lida == 0) lida = lerOpcaoMapa(argc, argv, &i, &territorios, &jogadores);
+        if (lida < 0) return EXIT_FAILURE;
+        if (lida > 0) continue;
+        int valida = 1;
+        if (strcmp(argv[i], "--partidas") == 0 && i + 1 < argc) {
+            valida = (partidas = atoi(argv[++i])) > 0;
+        } else if (strcmp(argv[i], "--rodadas") == 0 && i + 1 < argc) {
+            valida = (limiteRodadas = atoi(argv[++i])) > 0;
+        } else if (strcmp(argv[i], "--semente") == 0 && i + 1 < argc) {
+            semente = strtoull(argv[++i], NULL, 10);
+        } else {
+            valida = 0;
+        }
+        if (!valida) {
+            fprintf(stderr, "Uso: war alocacoes [--territorios N (padrão %d, 0 = mapa padrão)] [--jogadores 2..%d]\n"
+                            "                   [--partidas N] [--rodadas N] [--semente N]\n"
+                            "                   [opções de regras (padrão classica)] [--threads N]\n",
+                    TERRITORIOS_ALOCACOES, MAX_JOGADORES);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!conferirOpcaoMapa(territorios, &jogadores)) return EXIT_FAILURE;
+    if (!CONTA_ALOCACOES) {
+        fprintf(stderr, "Erro: este build não conta alocações; compile com -DCONTA_ALOCACOES=1 "
+                        "(exige glibc e nenhum sanitizador de memória).\n");
+        return EXIT_FAILURE;
+    }
+    if (!prepararRegras(&regras)) {
+        fprintf(stderr, "Erro: combinação de regras inválida (dados entre 1 e %d, mínimo na conquista >= 1).\n", MAX_DADOS);
+        return EXIT_FAILURE;
+    }
+
+    // o que o processo cria uma única vez fica fora da contagem: threads do pool e a biblioteca do backtrace()
+    prepararExecucaoParalela();
+#if CONTA_ALOCACOES
+    void *aquecimento[1];
+    backtrace(aquecimento, 1);
+#endif
+
+    long alocacoes = 0, liberacoes = 0;
+    int pilhasMostradas = 0;
+    printf("Alocações no laço da partida (%d partida(s), semente %llu):\n", partidas, (unsigned long long)semente);
+    for (int p = 0; p < partidas; ++p) {
+        Jogo jogo;
+        uint64_t s = semente + (uint64_t)p;
+        int criado = territorios > 0 ? criarJogoGerado(&jogo, &regras, s, territorios, jogadores)
+                                     : criarJogo(&jogo, &regras, s);
+        if (!criado) {
+            fprintf(stderr, "Erro: não foi possível criar a partida (2 a %d jogadores, ao menos um território por "
+                            "jogador).\n", MAX_JOGADORES);
+            return EXIT_FAILURE;
+        }
+        ligarContagemAlocacoes(1);
+        int vencedor = simularPartida(&jogo, limiteRodadas);
+        ligarContagemAlocacoes(0);
+
+        long a = atomic_load(&contagemAlocacoes.alocacoes), l = atomic_load(&contagemAlocacoes.liberacoes);
+        alocacoes += a;
+        liberacoes += l;
+        printf("  partida %d (semente %llu): %d rodada(s), %s, %ld alocação(ões), %ld liberação(ões)\n", p + 1,
+               (unsigned long long)s, jogo.rodada, vencedor >= 0 ? jogo.nomesJogadores[vencedor] : "sem vencedor", a,
+               l);
+        int guardadas = atomic_load(&contagemAlocacoes.totalPilhas);
+        if (guardadas > PILHAS_ALOCACAO) guardadas = PILHAS_ALOCACAO;
+        for (int k = 0; k < guardadas && pilhasMostradas < PILHAS_ALOCACAO; ++k, ++pilhasMostradas) {
+            printf("    %s chamado de:\n", contagemAlocacoes.funcao[k]);
+            fflush(stdout);
+#if CONTA_ALOCACOES
+            // a primeira entrada é o próprio registrarAlocacao()
+            backtrace_symbols_fd(contagemAlocacoes.pilha[k] + 1, contagemAlocacoes.profundidade[k] - 1, STDOUT_FILENO);
+#endif
+        }
+        liberarMemoria(&jogo);
+    }
+
+    if (alocacoes == 0 && liberacoes == 0) {
+        printf("OK: nenhuma partida pediu ou devolveu memória ao sistema depois de montada.\n");
+        return EXIT_SUCCESS;
+    }
+    printf("FALHA: %ld alocação(ões) e %ld liberação(ões) durante as partidas.\n", alocacoes, liberacoes);
+    if (pilhasMostradas > 0) {
+        printf("(nomes de funções nas pilhas exigem compilar com -rdynamic; sem isso, use addr2line nos endereços)\n");
+    }
+    return EXIT_FAILURE;
+}
+
+// Cadeia de Markov absorvente de uma partida entre exércitos automáticos, para a análise exata das missões.
+// Um estado transiente é o início do turno de um jogador (antes do reforço): dono e tropas de cada território mais
+// o jogador da vez, em 'tamanhoChave' bytes (as missões compiladas dependem só desse estado). Estados são numerados na ordem em que
+// são descobertos (busca em largura) e ficam num hash aberto; as transições ficam em formato compacto
+// (as de 'i' são destino/probabilidade[inicioTransicoes[i] .. inicioTransicoes[i + 1])). Destinos negativos
+// são absorções: -1 - destino é o jogador que cumpriu a missão.
+typedef struct {
+    size_t tamanhoChave;
+    unsigned char *chaves;
+    size_t totalEstados;
+    size_t capacidadeEstados;
+    int *tabela;                // índice do estado + 1 (0 = posição vazia)
+    size_t tamanhoTabela;
+    size_t *inicioTransicoes;
+    int *destino;
+    double *probabilidade;
+    size_t totalTransicoes;
+    size_t capacidadeTransicoes;
+} CadeiaMissoes;
+
+// hashChave():
+// FNV-1a sobre os bytes da chave.
+static uint64_t hashChave(const unsigned char *chave, size_t tamanho) {
+    uint64_t h = UINT64_C(1469598103934665603);
+    for (size_t i = 0; i < tamanho; ++i) h = (h ^ chave[i]) * UINT64_C(1099511628211);
+    return h;
+}
+
+// montarChave():
+// Escreve a chave do estado atual da partida com 'jogador' da vez (nas subposições de um turno, a etapa) no último
+// byte. Retorna 0 se alguma pilha não cabe em um byte.
+static int montarChave(const Jogo *jogo, int jogador, unsigned char *chave) {
+    for (size_t t = 0; t < jogo->total; ++t) {
+        if (jogo->territorios[t].tropas > UINT8_MAX) return 0;
+        chave[t] = (unsigned char)jogo->territorios[t].dono;
+        chave[jogo->total + t] = (unsigned char)jogo->territorios[t].tropas;
+    }
+    chave[2 * jogo->total] = (unsigned char)jogador;
+    return 1;
+}
+
+// buscarOuInserirEstado():
+// Índice do estado com a chave dada, criando-o (e dobrando tabela e vetores quando preciso) se for novo.
+// Retorna -1 se faltar memória ou se a cadeia passar de MAX_ESTADOS_CADEIA estados.
+static int buscarOuInserirEstado(CadeiaMissoes *c, const unsigned char *chave) {
+    if (2 * (c->totalEstados + 1) > c->tamanhoTabela) {
+        size_t tamanho = c->tamanhoTabela ? 2 * c->tamanhoTabela : 1024;
+        int *tabela = (int *)calloc(tamanho, sizeof(int));
+        if (tabela == NULL) return -1;
+        for (size_t i = 0; i < c->totalEstados; ++i) {
+            size_t h = (size_t)hashChave(&c->chaves[i * c->tamanhoChave], c->tamanhoChave) & (tamanho - 1);
+            while (tabela[h] != 0) h = (h + 1) & (tamanho - 1);
+            tabela[h] = (int)i + 1;
+        }
+        free(c->tabela);
+        c->tabela = tabela;
+        c->tamanhoTabela = tamanho;
+    }
+    size_t h = (size_t)hashChave(chave, c->tamanhoChave) & (c->tamanhoTabela - 1);
+    while (c->tabela[h] != 0) {
+        int i = c->tabela[h] - 1;
+        if (memcmp(&c->chaves[(size_t)i * c->tamanhoChave], chave, c->tamanhoChave) == 0) return i;
+        h = (h + 1) & (c->tamanhoTabela - 1);
+    }
+    if (c->totalEstados >= MAX_ESTADOS_CADEIA) return -1;
+    if (c->totalEstados == c->capacidadeEstados) {
+        size_t capacidade = c->capacidadeEstados ? 2 * c->capacidadeEstados : 1024;
+        unsigned char *chaves = (unsigned char *)realloc(c->chaves, capacidade * c->tamanhoChave);
+        if (chaves == NULL) return -1;
+        c->chaves = chaves;
+        size_t *inicio = (size_t *)realloc(c->inicioTransicoes, (capacidade + 1) * sizeof(size_t));
+        if (inicio == NULL) return -1;
+        c->inicioTransicoes = inicio;
+        c->capacidadeEstados = capacidade;
+    }
+    memcpy(&c->chaves[c->totalEstados * c->tamanhoChave], chave, c->tamanhoChave);
+    c->tabela[h] = (int)c->totalEstados + 1;
+    return (int)c->totalEstados++;
+}
+
+// adicionarTransicao():
+// Acrescenta uma transição do estado em construção. Retorna 0 se faltar memória.
+static int adicionarTransicao(CadeiaMissoes *c, int destino, double probabilidade) {
+    if (c->totalTransicoes == c->capacidadeTransicoes) {
+        size_t capacidade = c->capacidadeTransicoes ? 2 * c->capacidadeTransicoes : 4096;
+        int *destinos = (int *)realloc(c->destino, capacidade * sizeof(int));
+        if (destinos == NULL) return 0;
+        c->destino = destinos;
+        double *probabilidades = (double *)realloc(c->probabilidade, capacidade * sizeof(double));
+        if (probabilidades == NULL) return 0;
+        c->probabilidade = probabilidades;
+        c->capacidadeTransicoes = capacidade;
+    }
+    c->destino[c->totalTransicoes] = destino;
+    c->probabilidade[c->totalTransicoes++] = probabilidade;
+    return 1;
+}
+
+// carregarEstado():
+// Leva a partida ao estado da chave aplicando só as diferenças (trocas de dono e de tropas, com todos os
+// contadores incrementais) e recompila as missões, que dependem de quais exércitos já foram eliminados.
+static void carregarEstado(Jogo *jogo, const unsigned char *chave) {
+    for (size_t t = 0; t < jogo->total; ++t) {
+        if (jogo->territorios[t].dono != chave[t]) transferirTerritorio(jogo, t, chave[t]);
+    }
+    for (size_t t = 0; t < jogo->total; ++t) {
+        int delta = (int)chave[jogo->total + t] - jogo->territorios[t].tropas;
+        if (delta != 0) alterarTropas(jogo, t, delta);
+    }
+    for (int j = 0; j < jogo->totalJogadores; ++j) compilarMissao(jogo, jogo->missoes[j].id, j, &jogo->missoes[j]);
+}
+
+// esvaziarCadeia():
+// Descarta os estados e as transições da cadeia, mantendo a memória já reservada.
+static void esvaziarCadeia(CadeiaMissoes *c) {
+    if (c->tabela != NULL) memset(c->tabela, 0, c->tamanhoTabela * sizeof(int));
+    c->totalEstados = 0;
+    c->totalTransicoes = 0;
+}
+
+// distribuirBlitz():
+// Distribuição exata do fim de uma blitz de 'A' tropas contra 'D' (mesmas rolagens de executarBlitz()):
+// massa[a * (D + 1) + d] recebe a chance de o atacante terminar com 'a' tropas e o defensor com 'd' (d = 0 é a
+// conquista). Cada rolagem tira tropas de alguém, então basta uma passada com 'a' e 'd' decrescentes; rolagens
+// sem perda para ninguém entram como renormalização. 'massa' precisa de (A + 1) * (D + 1) posições.
+static void distribuirBlitz(const Jogo *jogo, int A, int D, double *massa) {
+    const Regras *regras = &jogo->regras;
+    const int largura = D + 1;
+    for (int k = 0; k < (A + 1) * largura; ++k) massa[k] = 0.0;
+    massa[A * largura + D] = 1.0;
+    for (int a = A; a > regras->guarnicao; --a) {
+        for (int d = D; d > 0; --d) {
+            double m = massa[a * largura + d];
+            if (m == 0.0) continue;
+            massa[a * largura + d] = 0.0;
+            int nA = a - regras->guarnicao < regras->dadosAtaque ? a - regras->guarnicao : regras->dadosAtaque;
+            int nD = d < regras->dadosDefesa ? d : regras->dadosDefesa;
+            int pares = nA < nD ? nA : nD;
+            const double *pk = jogo->blitz.probRolagem[nA - 1][nD - 1];
+            double laco = regras->atacantePerde ? 0.0 : pk[0];
+            for (int k = 0; k <= pares; ++k) {
+                int perdaAtaque = (pares - k) * regras->atacantePerde;
+                if (k == 0 && perdaAtaque == 0) continue;
+                massa[(a - perdaAtaque) * largura + (d - k)] += m * pk[k] / (1.0 - laco);
+            }
+        }
+    }
+}
+
+// Subposições de um turno da análise exata: a posição mais a etapa do turno no último byte da chave
+// (0 .. passos - 1 = passo do plano, passos + a = a-ésimo ataque livre, ETAPA_FIM_TURNO = turno encerrado).
+// Toda blitz leva a uma etapa maior, então expandir as etapas em ordem crescente junta toda a chance que chega a
+// uma subposição antes de ela ser expandida. A memória é reaproveitada de um turno para o outro.
+typedef struct {
+    CadeiaMissoes posicoes;
+    double *massa;                            // chance de cada subposição
+    int *proximoNaEtapa;                      // listas de subposições por etapa
+    size_t capacidade;
+    int primeiroDaEtapa[ETAPA_FIM_TURNO + 1];
+    double *blitz;                            // distribuição de distribuirBlitz(), (UINT8_MAX + 1)^2 posições
+} TurnoCadeia;
+
+// acumularSubposicao():
+// Soma 'massa' à subposição da posição carregada na etapa dada, criando-a se for nova. Retorna 0 em caso de erro.
+static int acumularSubposicao(TurnoCadeia *t, const Jogo *jogo, int etapa, double massa, unsigned char *chave) {
+    if (!montarChave(jogo, etapa, chave)) return 0;
+    size_t antes = t->posicoes.totalEstados;
+    int s = buscarOuInserirEstado(&t->posicoes, chave);
+    if (s < 0) return 0;
+    if ((size_t)s == antes) {
+        if (antes == t->capacidade) {
+            size_t capacidade = t->capacidade ? 2 * t->capacidade : 1024;
+            double *massas = (double *)realloc(t->massa, capacidade * sizeof(double));
+            if (massas == NULL) return 0;
+            t->massa = massas;
+            int *proximos = (int *)realloc(t->proximoNaEtapa, capacidade * sizeof(int));
+            if (proximos == NULL) return 0;
+            t->proximoNaEtapa = proximos;
+            t->capacidade = capacidade;
+        }
+        t->massa[s] = 0.0;
+        t->proximoNaEtapa[s] = t->primeiroDaEtapa[etapa];
+        t->primeiroDaEtapa[etapa] = s;
+    }
+    t->massa[s] += massa;
+    return 1;
+}
+
+// blitzSubposicao():
+// Espalha a chance 'massa' da subposição 's' (já carregada) pelos fins da blitz de 'origem' em 'alvo', como
+// executarBlitz(): conquistas vão para 'etapaConquista' e derrotas para 'etapaDerrota'. Quando o verificar
+// correspondente está ligado, o que cumpre a missão de 'jogador' vai para *vitoria. Retorna 0 em caso de erro.
+static int blitzSubposicao(TurnoCadeia *t, Jogo *jogo, int s, int jogador, int origem, int alvo, double massa,
+                           int etapaConquista, int verificarConquista, int etapaDerrota, int verificarDerrota,
+                           double *vitoria, unsigned char *chave) {
+    int A = jogo->territorios[origem].tropas, D = jogo->territorios[alvo].tropas;
+    distribuirBlitz(jogo, A, D, t->blitz);
+    for (int a = 0; a <= A; ++a) {
+        for (int d = 0; d <= D; ++d) {
+            double p = t->blitz[a * (D + 1) + d];
+            if (p == 0.0) continue;
+            if (a != A) alterarTropas(jogo, (size_t)origem, a - A);
+            if (d != D) alterarTropas(jogo, (size_t)alvo, d - D);
+            if (d == 0) conquistarTerritorio(jogo, (size_t)origem, (size_t)alvo, a - 1);
+            int verificar = d == 0 ? verificarConquista : verificarDerrota;
+            if (verificar && verificarVitoria(jogo, jogador)) {
+                *vitoria += massa * p;
+            } else if (!acumularSubposicao(t, jogo, d == 0 ? etapaConquista : etapaDerrota, massa * p, chave)) {
+                return 0;
+            }
+            carregarEstado(jogo, &t->posicoes.chaves[(size_t)s * t->posicoes.tamanhoChave]);
+        }
+    }
+    return 1;
+}
+
+// expandirEstado():
+// Gera as transições do estado 'i' (início do turno de um jogador) jogando o turno inteiro de
+// jogarTurnoAutomatico() com todos os desfechos possíveis: reforço, plano (calculado uma vez, já que a posição
+// depois do reforço não depende do acaso), até ATAQUES_POR_TURNO blitz de escolherAtaqueAutomatico() e o
+// remanejamento. Cada blitz entra pela distribuição exata do seu fim. As posições em que o turno termina viram
+// transições para o turno do próximo exército vivo; as que cumprem a missão, absorção. Marca teto[i] se
+// jogo->limiteTropas cortou algum reforço ou remanejamento no turno. Retorna 0 em caso de erro.
+static int expandirEstado(CadeiaMissoes *c, TurnoCadeia *t, Jogo *jogo, size_t i, unsigned char *teto,
+                          unsigned char *chave) {
+    const size_t n = jogo->total;
+    int jogador = c->chaves[i * c->tamanhoChave + 2 * n];
+    double vitoria = 0.0;
+    c->inicioTransicoes[i] = c->totalTransicoes;
+    carregarEstado(jogo, &c->chaves[i * c->tamanhoChave]);
+    esvaziarCadeia(&t->posicoes);
+    for (int e = 0; e <= ETAPA_FIM_TURNO; ++e) t->primeiroDaEtapa[e] = -1;
+
+    PlanoAtaque plano = {0};
+    teto[i] = (unsigned char)reforcarAutomatico(jogo, jogador);
+    if (verificarVitoria(jogo, jogador)) {
+        vitoria = 1.0;
+    } else {
+        if (!planejarAtaques(jogo, jogador, &plano) || plano.probabilidade < jogo->limiarAtaque[jogador]) plano.total = 0;
+        if (!acumularSubposicao(t, jogo, 0, 1.0, chave)) return 0;
+    }
+    reiniciarArena(jogo->rascunho);
+
+    for (int e = 0; e < ETAPA_FIM_TURNO; ++e) {
+        for (int s = t->primeiroDaEtapa[e]; s >= 0; s = t->proximoNaEtapa[s]) {
+            carregarEstado(jogo, &t->posicoes.chaves[(size_t)s * t->posicoes.tamanhoChave]);
+            double massa = t->massa[s];
+            int origem, alvo, ok;
+            if (e < plano.total) {
+                // a vitória só é verificada depois do plano inteiro (ou da primeira blitz que falhar)
+                ok = blitzSubposicao(t, jogo, s, jogador, plano.origem[e], plano.destino[e], massa, e + 1,
+                                     e + 1 == plano.total, plano.total, 1, &vitoria, chave);
+            } else if (e - plano.total < ATAQUES_POR_TURNO && escolherAtaqueAutomatico(jogo, jogador, &origem, &alvo)) {
+                ok = blitzSubposicao(t, jogo, s, jogador, origem, alvo, massa, e + 1, 1, e + 1, 0, &vitoria, chave);
+            } else {
+                if (remanejarAutomatico(jogo, jogador)) teto[i] = 1;
+                if (verificarVitoria(jogo, jogador)) {
+                    vitoria += massa;
+                    ok = 1;
+                } else {
+                    ok = acumularSubposicao(t, jogo, ETAPA_FIM_TURNO, massa, chave);
+                }
+            }
+            if (!ok) return 0;
+        }
+    }
+
+    if (vitoria > 0.0 && !adicionarTransicao(c, -1 - jogador, vitoria)) return 0;
+    for (int s = t->primeiroDaEtapa[ETAPA_FIM_TURNO]; s >= 0; s = t->proximoNaEtapa[s]) {
+        carregarEstado(jogo, &t->posicoes.chaves[(size_t)s * t->posicoes.tamanhoChave]);
+        int proximo = jogador;
+        do {
+            proximo = (proximo + 1) % jogo->totalJogadores;
+        } while (jogo->territoriosJogador[proximo] == 0);
+        if (!montarChave(jogo, proximo, chave)) return 0;
+        int destino = buscarOuInserirEstado(c, chave);
+        if (destino < 0 || !adicionarTransicao(c, destino, t->massa[s])) return 0;
+    }
+    return 1;
+}
+
+// atualizarEstadoCadeia():
+// Uma atualização de Gauss-Seidel do estado 's': x[s] = soma_t P(s, t) x[t] + P(s, absorção por j), com 'J'
+// colunas por estado (os jogadores e os dois desfechos sem vencedor). Retorna a maior mudança entre as colunas.
+static double atualizarEstadoCadeia(const CadeiaMissoes *c, int J, double *x, size_t s) {
+    double novo[COLUNAS_CADEIA(MAX_JOGADORES)];
+    for (int j = 0; j < J; ++j) novo[j] = 0.0;
+    for (size_t e = c->inicioTransicoes[s]; e < c->inicioTransicoes[s + 1]; ++e) {
+        int d = c->destino[e];
+        if (d < 0) {
+            novo[-1 - d] += c->probabilidade[e];
+        } else {
+            const double *xd = &x[(size_t)d * (size_t)J];
+            for (int j = 0; j < J; ++j) novo[j] += c->probabilidade[e] * xd[j];
+        }
+    }
+    double *xs = &x[s * (size_t)J];
+    double mudanca = 0.0;
+    for (int j = 0; j < J; ++j) {
+        double diferenca = novo[j] > xs[j] ? novo[j] - xs[j] : xs[j] - novo[j];
+        if (diferenca > mudanca) mudanca = diferenca;
+        xs[j] = novo[j];
+    }
+    return mudanca;
+}
+
+// resolverComponentes():
+// Resolve x = P x + b por componentes fortemente conexas (Tarjan iterativo). Cada componente fica pronta só
+// depois de todas as que ela alcança, então é resolvida assim que fecha: estados fora de ciclos (a maioria, pois
+// ataques só tiram tropas) saem numa única passada e só os ciclos (reforços que recolocam tropas) precisam de
+// varreduras de Gauss-Seidel, partindo de x = 0 até a maior mudança ficar abaixo de TOLERANCIA_CADEIA.
+// Uma componente fechada (sem saída) é um ciclo de que a partida nunca sai: sua chance vai para a coluna J
+// ("preso no teto") se o teto de tropas cortou algo em algum de seus turnos (teto[s]) e para J + 1 ("sem fim")
+// se não. Escreve em *maiorCiclo o tamanho da maior componente. Retorna 0 se faltar memória.
+static int resolverComponentes(const CadeiaMissoes *c, int J, const unsigned char *teto, double *x, size_t *maiorCiclo) {
+    size_t n = c->totalEstados;
+    const int colunas = COLUNAS_CADEIA(J);
+    int *indice = (int *)malloc(n * sizeof(int));
+    int *baixo = (int *)malloc(n * sizeof(int));
+    int *pilha = (int *)malloc(n * sizeof(int));
+    int *chamadas = (int *)malloc(n * sizeof(int));
+    size_t *aresta = (size_t *)malloc(n * sizeof(size_t));
+    unsigned char *naPilha = (unsigned char *)calloc(n, sizeof(unsigned char));
+    unsigned char *membro = (unsigned char *)calloc(n, sizeof(unsigned char));
+    int ok = indice != NULL && baixo != NULL && pilha != NULL && chamadas != NULL && aresta != NULL &&
+             naPilha != NULL && membro != NULL;
+    *maiorCiclo = 0;
+    if (ok) {
+        for (size_t i = 0; i < n; ++i) indice[i] = -1;
+        int proximoIndice = 0;
+        size_t topoPilha = 0;
+        for (size_t raiz = 0; raiz < n; ++raiz) {
+            if (indice[raiz] >= 0) continue;
+            size_t topoChamadas = 0;
+            chamadas[topoChamadas++] = (int)raiz;
+            indice[raiz] = baixo[raiz] = proximoIndice++;
+            aresta[raiz] = c->inicioTransicoes[raiz];
+            pilha[topoPilha++] = (int)raiz;
+            naPilha[raiz] = 1;
+            while (topoChamadas > 0) {
+                int v = chamadas[topoChamadas - 1];
+                int desceu = 0;
+                while (aresta[v] < c->inicioTransicoes[v + 1]) {
+                    int d = c->destino[aresta[v]++];
+                    if (d < 0) continue;
+                    if (indice[d] < 0) {
+                        indice[d] = baixo[d] = proximoIndice++;
+                        aresta[d] = c->inicioTransicoes[d];
+                        pilha[topoPilha++] = d;
+                        naPilha[d] = 1;
+                        chamadas[topoChamadas++] = d;
+                        desceu = 1;
+                        break;
+                    }
+                    if (naPilha[d] && indice[d] < baixo[v]) baixo[v] = indice[d];
+                }
+                if (desceu) continue;
+
+                if (baixo[v] == indice[v]) {
+                    // componente fechada: membros no topo da pilha, até 'v'
+                    size_t inicio = topoPilha;
+                    do {
+                        naPilha[pilha[--inicio]] = 0;
+                    } while (pilha[inicio] != v);
+                    size_t tamanho = topoPilha - inicio;
+                    if (tamanho > *maiorCiclo) *maiorCiclo = tamanho;
+                    int ciclo = tamanho > 1;
+                    for (size_t e = c->inicioTransicoes[v]; !ciclo && e < c->inicioTransicoes[v + 1]; ++e) {
+                        ciclo = c->destino[e] == v;
+                    }
+                    int fechada = ciclo, cortada = 0;
+                    for (size_t k = inicio; k < topoPilha; ++k) membro[pilha[k]] = 1;
+                    for (size_t k = inicio; fechada && k < topoPilha; ++k) {
+                        int s = pilha[k];
+                        cortada |= teto[s];
+                        for (size_t e = c->inicioTransicoes[s]; fechada && e < c->inicioTransicoes[s + 1]; ++e) {
+                            fechada = c->destino[e] >= 0 && membro[c->destino[e]];
+                        }
+                    }
+                    for (size_t k = inicio; k < topoPilha; ++k) membro[pilha[k]] = 0;
+                    if (fechada) {
+                        for (size_t k = inicio; k < topoPilha; ++k) {
+                            x[(size_t)pilha[k] * (size_t)colunas + (size_t)(cortada ? J : J + 1)] = 1.0;
+                        }
+                    } else {
+                        // varre na ordem inversa de descoberta, como as transições tendem a apontar
+                        if (tamanho > 1) qsort(&pilha[inicio], tamanho, sizeof(int), compararIndices);
+                        int varreduras = 0;
+                        double mudanca;
+                        do {
+                            mudanca = 0.0;
+                            for (size_t k = topoPilha; k-- > inicio;) {
+                                double m = atualizarEstadoCadeia(c, colunas, x, (size_t)pilha[k]);
+                                if (m > mudanca) mudanca = m;
+                            }
+                        } while (ciclo && mudanca > TOLERANCIA_CADEIA && ++varreduras < ITERACOES_CADEIA);
+                    }
+                    topoPilha = inicio;
+                }
+                topoChamadas--;
+                if (topoChamadas > 0) {
+                    int u = chamadas[topoChamadas - 1];
+                    if (baixo[v] < baixo[u]) baixo[u] = baixo[v];
+                }
+            }
+        }
+    }
+    free(indice);
+    free(baixo);
+    free(pilha);
+    free(chamadas);
+    free(aresta);
+    free(naPilha);
+    free(membro);
+    return ok;
+}
+
+// resolverCadeiaMissoes():
+// Probabilidade exata de cada jogador cumprir a missão quando a partida continua a partir do estado atual, no
+// início do turno de 'jogador', com todos jogando exatamente os turnos de jogarTurnoAutomatico() (reforço, plano,
+// blitz e remanejamento). Reforços e remanejamentos não levam territórios além de 'limiteTropas' tropas, o que
+// mantém a cadeia finita. Todos os estados alcançáveis são enumerados e o sistema x = P x + b da cadeia absorvente
+// é resolvido por resolverComponentes(). Escreve em vitoria[j] a chance de 'j', em vitoria[J] a de a partida ficar
+// para sempre num ciclo criado pelo teto de tropas, em vitoria[J + 1] a de ela ficar para sempre num ciclo em que o
+// teto não interfere, e os tamanhos em 'resumo' (estados, transições, maior ciclo). A partida é devolvida ao
+// estado original. Retorna 0 se faltar memória ou se a cadeia passar de MAX_ESTADOS_CADEIA estados.
+int resolverCadeiaMissoes(Jogo *jogo, int jogador, int limiteTropas, double *vitoria, size_t resumo[3]) {
+    const int J = jogo->totalJogadores, colunas = COLUNAS_CADEIA(J);
+    const size_t n = jogo->total;
+    const int limiteOriginal = jogo->limiteTropas;
+    CadeiaMissoes c = {0};
+    TurnoCadeia turno = {0};
+    c.tamanhoChave = turno.posicoes.tamanhoChave = 2 * n + 1;
+    unsigned char *original = (unsigned char *)malloc(c.tamanhoChave);
+    unsigned char *chave = (unsigned char *)malloc(c.tamanhoChave);
+    unsigned char *teto = NULL;
+    MissaoCompilada *missoes = (MissaoCompilada *)malloc((size_t)J * sizeof(MissaoCompilada));
+    EstatisticasJogador *estatisticas = (EstatisticasJogador *)malloc((size_t)J * sizeof(EstatisticasJogador));
+    turno.blitz = (double *)malloc((size_t)(UINT8_MAX + 1) * (UINT8_MAX + 1) * sizeof(double));
+    double *x = NULL;
+    int ok = 0;
+    for (int j = 0; j < colunas; ++j) vitoria[j] = 0.0;
+    resumo[0] = resumo[1] = resumo[2] = 0;
+    if (original == NULL || chave == NULL || missoes == NULL || estatisticas == NULL || turno.blitz == NULL ||
+        J > UINT8_MAX || !montarChave(jogo, jogador, original)) {
+        goto fim;
+    }
+    memcpy(missoes, jogo->missoes, (size_t)J * sizeof(MissaoCompilada));
+    memcpy(estatisticas, jogo->estatisticas, (size_t)J * sizeof(EstatisticasJogador));
+    jogo->limiteTropas = limiteTropas;
+
+    if (buscarOuInserirEstado(&c, original) != 0) goto fim;
+    size_t capacidadeTeto = 0;
+    for (size_t i = 0; i < c.totalEstados; ++i) {
+        if (c.capacidadeEstados > capacidadeTeto) {
+            unsigned char *maior = (unsigned char *)realloc(teto, c.capacidadeEstados);
+            if (maior == NULL) goto fim;
+            teto = maior;
+            capacidadeTeto = c.capacidadeEstados;
+        }
+        if (!expandirEstado(&c, &turno, jogo, i, teto, chave)) goto fim;
+    }
+    c.inicioTransicoes[c.totalEstados] = c.totalTransicoes;
+
+    x = (double *)calloc(c.totalEstados * (size_t)colunas, sizeof(double));
+    if (x == NULL || !resolverComponentes(&c, J, teto, x, &resumo[2])) goto fim;
+    for (int j = 0; j < colunas; ++j) vitoria[j] = x[j]; // o estado inicial é o 0
+    ok = 1;
+
+fim:
+    resumo[0] = c.totalEstados;
+    resumo[1] = c.totalTransicoes;
+    jogo->limiteTropas = limiteOriginal;
+    if (original != NULL && missoes != NULL && estatisticas != NULL) {
+        memcpy(jogo->missoes, missoes, (size_t)J * sizeof(MissaoCompilada));
+        carregarEstado(jogo, original);
+        memcpy(jogo->estatisticas, estatisticas, (size_t)J * sizeof(EstatisticasJogador));
+    }
+    reiniciarArena(jogo->rascunho);
+    free(x);
+    free(c.chaves);
+    free(c.tabela);
+    free(c.inicioTransicoes);
+    free(c.destino);
+    free(c.probabilidade);
+    free(turno.posicoes.chaves);
+    free(turno.posicoes.tabela);
+    free(turno.posicoes.inicioTransicoes);
+    free(turno.massa);
+    free(turno.proximoNaEtapa);
+    free(turno.blitz);
+    free(teto);
+    free(original);
+    free(chave);
+    free(missoes);
+    free(estatisticas);
+    return ok;
+}
+
+// verificarAnaliseExata():
+// Confere a análise exata ('vitoria', de resolverCadeiaMissoes()) contra 'partidas' partidas de continuarPartida()
+// jogadas a partir da mesma posição e das mesmas missões, com o mesmo teto de tropas e os dados da partida 'p'
+// sorteados com a semente 'semente + 1 + p'. A chance exata de cada jogador precisa ficar entre a frequência
+// simulada menos a margem e a frequência mais a margem somada à folga: as partidas simuladas que chegaram a
+// 'limiteRodadas' além das que a cadeia prevê presas para sempre (a cadeia não tem limite de rodadas, então
+// essas ainda podem terminar com vitória). A chance exata de não haver vencedor também não pode passar da
+// frequência simulada mais a margem. A margem é de 4 desvios-padrão binomiais mais 1/partidas.
+// A partida é devolvida ao estado original. Retorna 1 se tudo concordar.
+static int verificarAnaliseExata(Jogo *jogo, const double *vitoria, int limiteTropas, int partidas, int limiteRodadas,
+                                 uint64_t semente) {
+    const int J = jogo->totalJogadores;
+    unsigned char *original = (unsigned char *)malloc(2 * jogo->total + 1);
+    MissaoCompilada *missoes = (MissaoCompilada *)malloc((size_t)J * sizeof(MissaoCompilada));
+    long long *vitorias = (long long *)calloc((size_t)J + 1, sizeof(long long)); // [J] = sem vencedor no limite
+    int concordam = original != NULL && missoes != NULL && vitorias != NULL && montarChave(jogo, 0, original);
+    if (concordam) {
+        memcpy(missoes, jogo->missoes, (size_t)J * sizeof(MissaoCompilada));
+        jogo->limiteTropas = limiteTropas;
+        for (int p = 0; p < partidas; ++p) {
+            memcpy(jogo->missoes, missoes, (size_t)J * sizeof(MissaoCompilada));
+            carregarEstado(jogo, original);
+            semearGerador(&jogo->rng, semente + 1 + (uint64_t)p);
+            int vencedor = continuarPartida(jogo, limiteRodadas);
+            vitorias[vencedor >= 0 ? vencedor : J]++;
+        }
+        jogo->limiteTropas = INT32_MAX;
+        memcpy(jogo->missoes, missoes, (size_t)J * sizeof(MissaoCompilada));
+        carregarEstado(jogo, original);
+
+        double semFim = (double)vitorias[J] / partidas, exatoSemFim = vitoria[J] + vitoria[J + 1];
+        double folga = semFim > exatoSemFim ? semFim - exatoSemFim : 0.0;
+        printf("=== Verificação por simulação (%d partida(s), até %d rodada(s)) ===\n", partidas, limiteRodadas);
+        for (int j = 0; j < J; ++j) {
+            double f = (double)vitorias[j] / partidas;
+            double margem = 4.0 * sqrt(f * (1.0 - f) / partidas) + 1.0 / partidas;
+            int ok = vitoria[j] >= f - margem && vitoria[j] <= f + folga + margem;
+            printf("  %-14s exato %7.3f%% | simulado %7.3f%% ± %.3f%%%s\n", jogo->nomesJogadores[j], 100.0 * vitoria[j],
+                   100.0 * f, 100.0 * margem, ok ? "" : "  <- diverge");
+            concordam &= ok;
+        }
+        double margem = 4.0 * sqrt(semFim * (1.0 - semFim) / partidas) + 1.0 / partidas;
+        int ok = exatoSemFim <= semFim + margem;
+        printf("  %-14s simulado %7.3f%% ± %.3f%% (exato: %.3f%% sem fim + %.3f%% preso no teto)%s\n", "sem vencedor",
+               100.0 * semFim, 100.0 * margem, 100.0 * vitoria[J + 1], 100.0 * vitoria[J], ok ? "" : "  <- diverge");
+        concordam &= ok;
+        printf(concordam ? "OK: a análise exata e a simulação concordam.\n"
+                         : "DIVERGÊNCIA: a análise exata e a simulação não concordam.\n");
+    }
+    free(original);
+    free(missoes);
+    free(vitorias);
+    return concordam;
+}
+
+// executarAnaliseExata():
+// Subcomando "exato": distribui as missões de uma partida nova e mostra a chance exata de cada exército cumprir a
+// sua (cadeia de Markov absorvente), no lugar de milhões de partidas simuladas. Pensado para mapas pequenos:
+// o número de estados cresce com o limite de tropas e o número de territórios. Com --verificar N, o resultado é
+// conferido contra N partidas simuladas com a mesma política e o mesmo teto (falha se não concordarem).
+int executarAnaliseExata(int argc, char *argv[]) {
+    Regras regras = variantesRegras[0];
+    size_t territorios = 0;
+    int jogadores = 0;
+    int limiteTropas = TROPAS_CADEIA, partidasVerificacao = 0, limiteRodadas = RODADAS_SIMULACAO;
+    uint64_t semente = (uint64_t)time(NULL);
+    for (int i = 1; i < argc; ++i) {
+        int lida = lerOpcaoRegras(argc, argv, &i, &regras);
+        if (lida == 0) lida = lerOpcaoMapa(argc, argv, &i, &territorios, &jogadores);
+        if (lida < 0) return EXIT_FAILURE;
+        if (lida > 0) continue;
+        if (strcmp(argv[i], "--tropas-max") == 0 && i + 1 < argc && converterInteiro(argv[i + 1], &limiteTropas)) {
+            ++i;
+        } else if (strcmp(argv[i], "--semente") == 0 && i + 1 < argc) {
+            semente = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--verificar") == 0 && i + 1 < argc && converterInteiro(argv[i + 1], &partidasVerificacao) &&
+                   partidasVerificacao > 0) {
+            ++i;
+        } else if (strcmp(argv[i], "--rodadas") == 0 && i + 1 < argc && converterInteiro(argv[i + 1], &limiteRodadas) &&
+                   limiteRodadas > 0) {
+            ++i;
+        } else {
+            fprintf(stderr, "Uso: war exato [--territorios N (0 = mapa padrão)] [--jogadores 2..%d] [--tropas-max N]\n"
+                            "               [--semente N] [--verificar PARTIDAS [--rodadas N]] [opções de regras]\n",
+                    MAX_JOGADORES);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!conferirOpcaoMapa(territorios, &jogadores)) return EXIT_FAILURE;
+    if (!prepararRegras(&regras)) {
+        fprintf(stderr, "Erro: combinação de regras inválida (dados entre 1 e %d, mínimo na conquista >= 1).\n", MAX_DADOS);
+        return EXIT_FAILURE;
+    }
+    if (limiteTropas < 1 || limiteTropas > UINT8_MAX) {
+        fprintf(stderr, "Erro: --tropas-max deve ficar entre 1 e %d.\n", UINT8_MAX);
+        return EXIT_FAILURE;
+    }
+
+    Jogo jogo;
+    int criado = territorios > 0 ? criarJogoGerado(&jogo, &regras, semente, territorios, jogadores)
+                                 : criarJogo(&jogo, &regras, semente);
+    if (!criado) {
+        fprintf(stderr, "Erro: não foi possível criar o mapa (2 a %d jogadores, ao menos um território por jogador).\n",
+                MAX_JOGADORES);
+        return EXIT_FAILURE;
+    }
+    distribuirMissoes(&jogo);
+
+    double vitoria[COLUNAS_CADEIA(MAX_JOGADORES)];
+    size_t resumo[3];
+    if (!resolverCadeiaMissoes(&jogo, 0, limiteTropas, vitoria, resumo)) {
+        fprintf(stderr, "Erro: a cadeia passou de %u estados ou faltou memória (%zu estados enumerados); "
+                        "reduza --tropas-max ou o mapa.\n", MAX_ESTADOS_CADEIA, resumo[0]);
+        liberarMemoria(&jogo);
+        return EXIT_FAILURE;
+    }
+
+    printf("=== Análise exata (semente %llu, regras %s, até %d tropas por território em reforços e remanejamentos) ===\n",
+           (unsigned long long)semente, regras.nome, limiteTropas);
+    printf("Estados: %zu | transições: %zu | maior ciclo: %zu estado(s)\n", resumo[0], resumo[1], resumo[2]);
+    char descricao[MISS_DESC_TAM], cor[24];
+    for (int j = 0; j < jogo.totalJogadores; ++j) {
+        descreverMissao(&jogo, &jogo.missoes[j], descricao, sizeof(descricao));
+        codigoCorJogador(j, cor, sizeof(cor));
+        printf("  %s%-14s%s %7.3f%%  %s\n", cor, jogo.nomesJogadores[j], cor[0] != '\0' ? resetANSI : "",
+               100.0 * vitoria[j], descricao);
+    }
+    printf("  %-14s %7.3f%%  ciclo sem fim em que o teto de tropas não interfere\n", "sem vencedor",
+           100.0 * vitoria[jogo.totalJogadores + 1]);
+    printf("  %-14s %7.3f%%  ciclo sem fim criado pelo teto de tropas (aumente --tropas-max)\n", "preso no teto",
+           100.0 * vitoria[jogo.totalJogadores]);
+    int codigo = EXIT_SUCCESS;
+    if (partidasVerificacao > 0 &&
+        !verificarAnaliseExata(&jogo, vitoria, limiteTropas, partidasVerificacao, limiteRodadas, semente)) {
+        codigo = EXIT_FAILURE;
+    }
+    liberarMemoria(&jogo);
+    return codigo;
+}
+
+// Rolagens inclinadas da amostragem por importância. Cada rolagem com nA dados contra nD tem k = 0..pares perdas
+// do defensor com chance p_k (probRolagem da tabela de blitz); a inclinação sorteia k com chance proporcional a
+// p_k·e^(inclinação·s_k), onde s_k = perdas do defensor - perdas do atacante é o avanço rumo à conquista.
+// Cada rolagem multiplica o peso da amostra por p_k / q_k, o que mantém a estimativa sem viés para dados honestos.
+typedef struct {
+    double acumulada[MAX_DADOS][MAX_DADOS][MAX_DADOS + 1]; // [nA - 1][nD - 1][k]: distribuição acumulada de q
+    double logPeso[MAX_DADOS][MAX_DADOS][MAX_DADOS + 1];   // log(p_k / q_k)
+} RolagensInclinadas;
+
+// Lote da amostragem por importância: cada bloco tem o próprio gerador (semente + bloco) e as próprias somas,
+// reduzidas em ordem no fim, então o resultado não depende da quantidade de threads.
+typedef struct {
+    const Regras *regras;
+    RolagensInclinadas rolagens;
+    int tropasAtaque;
+    int tropasDefesa;
+    uint64_t semente;
+    long long amostras;
+    double soma[BLOCOS_IMPORTANCIA];
+    double somaQuadrados[BLOCOS_IMPORTANCIA];
+    long long acertos[BLOCOS_IMPORTANCIA];
+} ContextoImportancia;
+
+// inclinarRolagens():
+// Monta as distribuições inclinadas de cada combinação de dados (inclinação 0 = dados honestos, peso sempre 1).
+static void inclinarRolagens(RolagensInclinadas *rolagens, const TabelaBlitz *tabela, const Regras *regras,
+                             double inclinacao) {
+    for (int nA = 1; nA <= MAX_DADOS; ++nA) {
+        for (int nD = 1; nD <= MAX_DADOS; ++nD) {
+            int pares = nA < nD ? nA : nD;
+            const double *p = tabela->probRolagem[nA - 1][nD - 1];
+            double q[MAX_DADOS + 1] = {0}, total = 0.0, acumulada = 0.0;
+            for (int k = 0; k <= pares; ++k) total += q[k] = p[k] * exp(inclinacao * (k - (pares - k) * regras->atacantePerde));
+            for (int k = 0; k <= MAX_DADOS; ++k) {
+                q[k] /= total;
+                rolagens->acumulada[nA - 1][nD - 1][k] = k < pares ? acumulada += q[k] : 1.0;
+                rolagens->logPeso[nA - 1][nD - 1][k] = q[k] > 0.0 ? log(p[k] / q[k]) : 0.0;
+            }
+        }
+    }
+}
+
+// blitzInclinada():
+// Joga uma blitz completa com as rolagens inclinadas (mesmas regras de executarBlitz(), sem mapa).
+// Retorna o peso da amostra se o atacante conquistar e 0 caso contrário.
+static double blitzInclinada(const Regras *regras, const RolagensInclinadas *rolagens, GeradorAleatorio *rng,
+                             int tropasAtaque, int tropasDefesa) {
+    double logPeso = 0.0;
+    while (tropasAtaque > regras->guarnicao && tropasDefesa > 0) {
+        int nA = tropasAtaque - regras->guarnicao < regras->dadosAtaque ? tropasAtaque - regras->guarnicao
+                                                                        : regras->dadosAtaque;
+        int nD = tropasDefesa < regras->dadosDefesa ? tropasDefesa : regras->dadosDefesa;
+        int pares = nA < nD ? nA : nD;
+        const double *acumulada = rolagens->acumulada[nA - 1][nD - 1];
+        double u = (double)(proximoAleatorio(rng) >> 11) * 0x1p-53;
+        int k = 0;
+        while (k < pares && u >= acumulada[k]) ++k;
+        logPeso += rolagens->logPeso[nA - 1][nD - 1][k];
+        tropasAtaque -= (pares - k) * regras->atacantePerde;
+        tropasDefesa -= k;
+    }
+    return tropasDefesa <= 0 ? exp(logPeso) : 0.0;
+}
+
+// amostrarBlocoImportancia():
+// Tarefa paralela: sorteia as amostras do bloco 'indice' (a sobra da divisão fica com os primeiros blocos).
+static void amostrarBlocoImportancia(void *contexto, size_t indice) {
+    ContextoImportancia *ctx = (ContextoImportancia *)contexto;
+    long long amostras = ctx->amostras / BLOCOS_IMPORTANCIA + ((long long)indice < ctx->amostras % BLOCOS_IMPORTANCIA);
+    GeradorAleatorio rng;
+    semearGerador(&rng, ctx->semente + indice);
+    double soma = 0.0, somaQuadrados = 0.0;
+    long long acertos = 0;
+    for (long long k = 0; k < amostras; ++k) {
+        double peso = blitzInclinada(ctx->regras, &ctx->rolagens, &rng, ctx->tropasAtaque, ctx->tropasDefesa);
+        soma += peso;
+        somaQuadrados += peso * peso;
+        acertos += peso > 0.0;
+    }
+    ctx->soma[indice] = soma;
+    ctx->somaQuadrados[indice] = somaQuadrados;
+    ctx->acertos[indice] = acertos;
+}
+
+// estimarBlitzRaro():
+// Estima a chance de 'tropasAtaque' conquistar 'tropasDefesa' com 'amostras' blitz de rolagens inclinadas e
+// reponderadas; com inclinação 0 é o Monte Carlo simples. Eventos raros (2 tropas contra 15, por exemplo)
+// ficam comuns sob a inclinação, e o peso corrige a média. Retorna 0 se os parâmetros forem inválidos ou se
+// faltar memória.
+int estimarBlitzRaro(const Regras *regras, int tropasAtaque, int tropasDefesa, double inclinacao, long long amostras,
+                     uint64_t semente, EstimativaRara *estimativa) {
+    memset(estimativa, 0, sizeof(*estimativa));
+    if (tropasAtaque < 1 || tropasDefesa < 1 || amostras < 1) return 0;
+    ContextoImportancia *ctx = (ContextoImportancia *)calloc(1, sizeof(ContextoImportancia));
+    TabelaBlitz tabela;
+    if (ctx == NULL || !calcularTabelaBlitz(&tabela, regras)) {
+        free(ctx);
+        return 0;
+    }
+    ctx->regras = regras;
+    inclinarRolagens(&ctx->rolagens, &tabela, regras, inclinacao);
+    free(tabela.vitoria);
+    ctx->tropasAtaque = tropasAtaque;
+    ctx->tropasDefesa = tropasDefesa;
+    ctx->semente = semente;
+    ctx->amostras = amostras;
+    executarEmParalelo(BLOCOS_IMPORTANCIA, amostrarBlocoImportancia, ctx);
+
+    double soma = 0.0, somaQuadrados = 0.0;
+    for (int b = 0; b < BLOCOS_IMPORTANCIA; ++b) {
+        soma += ctx->soma[b];
+        somaQuadrados += ctx->somaQuadrados[b];
+        estimativa->acertos += ctx->acertos[b];
+    }
+    double n = (double)amostras, media = soma / n;
+    double variancia = n > 1.0 ? (somaQuadrados - n * media * media) / (n - 1.0) : 0.0;
+    estimativa->probabilidade = media;
+    estimativa->erroPadrao = variancia > 0.0 ? sqrt(variancia / n) : 0.0;
+    estimativa->amostrasEfetivas = somaQuadrados > 0.0 ? soma * soma / somaQuadrados : 0.0;
+    estimativa->amostras = amostras;
+    free(ctx);
+    return 1;
+}
+
+// escolherInclinacao():
+// Testa inclinações de -INCLINACAO_MAXIMA a INCLINACAO_MAXIMA (passo 0,25) com AMOSTRAS_PILOTO amostras cada e
+// fica com a de menor erro relativo entre as que tiveram ao menos 10 acertos (0 se nenhuma tiver).
+double escolherInclinacao(const Regras *regras, int tropasAtaque, int tropasDefesa, uint64_t semente) {
+    double melhor = 0.0, menorErro = 0.0;
+    for (double inclinacao = -INCLINACAO_MAXIMA; inclinacao <= INCLINACAO_MAXIMA + 1e-9; inclinacao += 0.25) {
+        EstimativaRara e;
+        if (!estimarBlitzRaro(regras, tropasAtaque, tropasDefesa, inclinacao, AMOSTRAS_PILOTO, semente, &e) ||
+            e.acertos < 10) {
+            continue;
+        }
+        double erro = e.erroPadrao / e.probabilidade;
+        if (menorErro == 0.0 || erro < menorErro) {
+            menorErro = erro;
+            melhor = inclinacao;
+        }
+    }
+    return melhor;
+}
+
+// executarBatalhaRara():
+// Subcomando "raro": estima a chance de uma blitz com amostragem por importância (inclinação dos dados
+// escolhida por pilotos ou dada em --inclinacao), compara com o Monte Carlo simples do mesmo tamanho e, se as
+// pilhas couberem na tabela de blitz, com o valor exato.
+int executarBatalhaRara(int argc, char *argv[]) {
+    Regras regras = variantesRegras[0];
+    int tropasAtaque = 2, tropasDefesa = 15;
+    long long amostras = 1000000;
+    double inclinacao = 0.0;
+    int inclinacaoDada = 0;
+    uint64_t semente = (uint64_t)time(NULL);
+    for (int i = 1; i < argc; ++i) {
+        int lida = lerOpcaoRegras(argc, argv, &i, &regras);
+        if (lida < 0) return EXIT_FAILURE;
+        if (lida > 0) continue;
+        int valida = 1;
+        if (strcmp(argv[i], "--ataque") == 0 && i + 1 < argc) {
+            valida = converterInteiro(argv[++i], &tropasAtaque);
+        } else if (strcmp(argv[i], "--defesa") == 0 && i + 1 < argc) {
+            valida = converterInteiro(argv[++i], &tropasDefesa);
+        } else if (strcmp(argv[i], "--amostras") == 0 && i + 1 < argc) {
+            valida = converterInteiroLongo(argv[++i], &amostras);
+        } else if (strcmp(argv[i], "--inclinacao") == 0 && i + 1 < argc) {
+            valida = converterReal(argv[++i], &inclinacao);
+            inclinacaoDada = 1;
+        } else if (strcmp(argv[i], "--semente") == 0 && i + 1 < argc) {
+            valida = converterNatural(argv[++i], &semente);
+        } else {
+            fprintf(stderr, "Uso: war raro [--ataque N] [--defesa N] [--amostras N] [--inclinacao X]\n"
+                            "              [--semente N] [opções de regras] [--threads N]\n");
+            return EXIT_FAILURE;
+        }
+        if (!valida) {
+            fprintf(stderr, "Erro: valor inválido para %s: '%s' (esperado um número%s).\n", argv[i - 1], argv[i],
+                    strcmp(argv[i - 1], "--inclinacao") == 0 ? "" : " inteiro");
+            return EXIT_FAILURE;
+        }
+    }
+    if (!prepararRegras(&regras)) {
+        fprintf(stderr, "Erro: combinação de regras inválida (dados entre 1 e %d, mínimo na conquista >= 1).\n", MAX_DADOS);
+        return EXIT_FAILURE;
+    }
+    if (tropasAtaque <= regras.guarnicao || tropasDefesa < 1 || amostras < 2) {
+        fprintf(stderr, "Erro: o atacante precisa de mais de %d tropa(s), o defensor de ao menos 1 e são precisas "
+                        "ao menos 2 amostras.\n", regras.guarnicao);
+        return EXIT_FAILURE;
+    }
+
+    if (!inclinacaoDada) inclinacao = escolherInclinacao(&regras, tropasAtaque, tropasDefesa, semente);
+    EstimativaRara importancia, simples;
+    if (!estimarBlitzRaro(&regras, tropasAtaque, tropasDefesa, inclinacao, amostras, semente + BLOCOS_IMPORTANCIA,
+                          &importancia) ||
+        !estimarBlitzRaro(&regras, tropasAtaque, tropasDefesa, 0.0, amostras, semente + 2 * BLOCOS_IMPORTANCIA,
+                          &simples)) {
+        fprintf(stderr, "Erro: memória insuficiente.\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("=== Blitz de %d contra %d tropa(s) (regras %s, %lld amostras) ===\n", tropasAtaque, tropasDefesa,
+           regras.nome, amostras);
+    printf("Inclinação das rolagens: %.2f (%s)\n", inclinacao,
+           inclinacaoDada ? "dada em --inclinacao" : "escolhida por amostras piloto");
+    printf("Importância: %.6e ± %.2e (IC 95%%) | %lld acerto(s) | amostras efetivas %.0f\n",
+           importancia.probabilidade, 1.96 * importancia.erroPadrao, importancia.acertos, importancia.amostrasEfetivas);
+    printf("Simples:     %.6e ± %.2e (IC 95%%) | %lld acerto(s)\n", simples.probabilidade, 1.96 * simples.erroPadrao,
+           simples.acertos);
+    if (tropasAtaque <= MAX_TROPAS_BLITZ && tropasDefesa <= MAX_TROPAS_BLITZ) {
+        TabelaBlitz tabela;
+        if (calcularTabelaBlitz(&tabela, &regras)) {
+            printf("Exato:       %.6e\n", probabilidadeBlitz(&tabela, tropasAtaque, tropasDefesa));
+            free(tabela.vitoria);
+        }
+    }
+    if (importancia.erroPadrao > 0.0) {
+        // amostras simples necessárias para o mesmo erro: p(1 - p) / variância por amostra da importância
+        double p = importancia.probabilidade;
+        double varianciaAmostra = importancia.erroPadrao * importancia.erroPadrao * (double)amostras;
+        printf("Ganho: o Monte Carlo simples precisaria de %.3gx mais amostras para o mesmo erro\n",
+               p * (1.0 - p) / varianciaAmostra);
+    }
+    return EXIT_SUCCESS;
+}
+
+// Pool de threads persistente usado por executarEmParalelo(). As threads ficam dormindo entre lotes;
+// cada lote distribui índices por um contador atômico e a thread chamadora também trabalha.
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t temTrabalho;
+    pthread_cond_t terminou;
+    pthread_mutex_t uso;         // apenas um lote por vez; chamadas concorrentes rodam em série
+    pthread_t *threads;
+    int totalThreads;            // threads desejadas, incluindo a chamadora (0 = automático)
+    int iniciadas;               // threads auxiliares criadas
+    unsigned geracao;            // incrementada a cada lote
+    int ativas;                  // auxiliares ainda trabalhando no lote atual
+    int encerrar;
+    TarefaParalela tarefa;
+    void *contexto;
+    size_t n;
+    atomic_size_t proximo;
+} pool = {.mutex = PTHREAD_MUTEX_INITIALIZER, .temTrabalho = PTHREAD_COND_INITIALIZER,
+          .terminou = PTHREAD_COND_INITIALIZER, .uso = PTHREAD_MUTEX_INITIALIZER};
+
+// Marca threads que já estão dentro de um lote paralelo (chamadas aninhadas rodam em série).
+static _Thread_local int dentroDeLoteParalelo = 0;
+
+// definirThreads():
+// Define quantas threads (incluindo a principal) os lotes paralelos usam. 0 ou negativo = núcleos disponíveis.
+void definirThreads(int total) {
+    pool.totalThreads = total > 0 ? total : 0;
+}
+
+// processarLote():
+// Consome índices do lote atual até acabarem.
+static void processarLote(void) {
+    size_t i;
+    while ((i = atomic_fetch_add(&pool.proximo, 1)) < pool.n) {
+        pool.tarefa(pool.contexto, i);
+    }
+}
+
+// trabalhadorPool():
+// Laço de cada thread auxiliar: espera um novo lote, processa e avisa quando terminar.
+static void *trabalhadorPool(void *arg) {
+    (void)arg;
+    unsigned vista = 0;
+    dentroDeLoteParalelo = 1;
+    pthread_mutex_lock(&pool.mutex);
+    for (;;) {
+        while (pool.geracao == vista && !pool.encerrar) pthread_cond_wait(&pool.temTrabalho, &pool.mutex);
+        if (pool.encerrar) break;
+        vista = pool.geracao;
+        pthread_mutex_unlock(&pool.mutex);
+        processarLote();
+        pthread_mutex_lock(&pool.mutex);
+        if (--pool.ativas == 0) pthread_cond_signal(&pool.terminou);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+    return NULL;
+}
+
+// iniciarPool():
+// Cria as threads auxiliares na primeira utilização. Retorna quantas threads auxiliares existem.
+static int iniciarPool(void) {
+    if (pool.threads != NULL) return pool.iniciadas;
+    int total = pool.totalThreads;
+    if (total <= 0) {
+        long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+        total = nucleos > 0 ? (int)nucleos : 1;
+    }
+    if (total <= 1) return 0;
+    pool.threads = (pthread_t *)calloc((size_t)(total - 1), sizeof(pthread_t));
+    if (pool.threads == NULL) return 0;
+    for (int i = 0; i < total - 1; ++i) {
+        if (pthread_create(&pool.threads[i], NULL, trabalhadorPool, NULL) != 0) break;
+        pool.iniciadas++;
+    }
+    return pool.iniciadas;
+}
+
+// executarEmParalelo():
+// Executa tarefa(contexto, i) para i em [0, n), distribuindo os índices entre as threads do pool.
+// Retorna somente depois de todos os índices terem sido processados. Lotes pequenos, chamadas aninhadas
+// ou concorrentes e máquinas de um núcleo executam em série na própria thread chamadora.
+void executarEmParalelo(size_t n, TarefaParalela tarefa, void *contexto) {
+    if (n < 2 || dentroDeLoteParalelo || pthread_mutex_trylock(&pool.uso) != 0) {
+        for (size_t i = 0; i < n; ++i) tarefa(contexto, i);
+        return;
+    }
+    if (iniciarPool() == 0) {
+        pthread_mutex_unlock(&pool.uso);
+        for (size_t i = 0; i < n; ++i) tarefa(contexto, i);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.mutex);
+    pool.tarefa = tarefa;
+    pool.contexto = contexto;
+    pool.n = n;
+    atomic_store(&pool.proximo, 0);
+    pool.ativas = pool.iniciadas;
+    pool.geracao++;
+    pthread_cond_broadcast(&pool.temTrabalho);
+    pthread_mutex_unlock(&pool.mutex);
+
+    dentroDeLoteParalelo = 1;
+    processarLote();
+    dentroDeLoteParalelo = 0;
+
+    pthread_mutex_lock(&pool.mutex);
+    while (pool.ativas > 0) pthread_cond_wait(&pool.terminou, &pool.mutex);
+    pthread_mutex_unlock(&pool.mutex);
+    pthread_mutex_unlock(&pool.uso);
+}
+
+// tarefaVazia():
+// Tarefa paralela que não faz nada (usada para acordar o pool).
+static void tarefaVazia(void *contexto, size_t indice) {
+    (void)contexto;
+    (void)indice;
+}
+
+// prepararExecucaoParalela():
+// Cria as threads do pool já, em vez de no primeiro lote, e espera cada uma passar por um lote vazio; quem mede
+// o trabalho dos lotes (a verificação de alocações) não vê o custo de criação das threads.
+void prepararExecucaoParalela(void) {
+    executarEmParalelo(2, tarefaVazia, NULL);
+}
+
+// encerrarExecucaoParalela():
+// Acorda e finaliza as threads do pool (chamada no fim do programa).
+void encerrarExecucaoParalela(void) {
+    if (pool.threads == NULL) return;
+    pthread_mutex_lock(&pool.mutex);
+    pool.encerrar = 1;
+    pthread_cond_broadcast(&pool.temTrabalho);
+    pthread_mutex_unlock(&pool.mutex);
+    for (int i = 0; i < pool.iniciadas; ++i) pthread_join(pool.threads[i], NULL);
+    free(pool.threads);
+    pool.threads = NULL;
+    pool.iniciadas = 0;
+    pool.encerrar = 0;
+}
+
+// buscarRegras():
+// Procura uma variante de regras pelo nome. Retorna NULL se o nome não for conhecido.
+const Regras *buscarRegras(const char *nome) {
+    for (size_t i = 0; i < TOTAL_VARIANTES; ++i) {
+        if (strcmp(variantesRegras[i].nome, nome) == 0) return &variantesRegras[i];
+    }
+    return NULL;
+}
+
+// Mínimo e máximo sem desvios condicionais (o compilador gera cmov/min/max).
+static inline int minSemDesvio(int a, int b) { return b ^ ((a ^ b) & -(a < b)); }
+static inline int maxSemDesvio(int a, int b) { return a ^ ((a ^ b) & -(a < b)); }
+
+// ordenarDadosDesc():
+// Rede de ordenação de 3 elementos (3 comparadores) em ordem decrescente, sem desvios.
+// Dados não usados valem 0 e portanto ficam no fim.
+static inline void ordenarDadosDesc(int *d) {
+    int a = maxSemDesvio(d[0], d[1]), b = minSemDesvio(d[0], d[1]);
+    int c = d[2];
+    int m = maxSemDesvio(b, c);
+    d[2] = minSemDesvio(b, c);
+    d[0] = maxSemDesvio(a, m);
+    d[1] = minSemDesvio(a, m);
+}
+
+// contarVitoriasAtaque():
+// Ordena os dados de cada lado e conta quantos pares (maior com maior, segundo com segundo...) o atacante vence.
+// Todo o cálculo é aritmético (sem desvios). Os vetores têm MAX_DADOS posições, com zeros nas não usadas.
+static inline __attribute__((always_inline)) int
+contarVitoriasAtaque(const int *dadosAtaque, const int *dadosDefesa, int pares, int empateAtacante) {
+    int a[MAX_DADOS] = {dadosAtaque[0], dadosAtaque[1], dadosAtaque[2]};
+    int d[MAX_DADOS] = {dadosDefesa[0], dadosDefesa[1], dadosDefesa[2]};
+    ordenarDadosDesc(a);
+    ordenarDadosDesc(d);
+    int vitoriasAtaque = 0;
+    for (int i = 0; i < MAX_DADOS; ++i) {
+        vitoriasAtaque += (i < pares) & (a[i] + empateAtacante > d[i]);
+    }
+    return vitoriasAtaque;
+}
+
+// compararDados():
+// Versão genérica (regras lidas em tempo de execução) da comparação de uma rolagem já sorteada.
+// Cada par perdido custa uma tropa; empates seguem a variante de regras.
+// Os vetores precisam ter MAX_DADOS posições, com zeros nas posições não usadas.
+ResultadoRolagem compararDados(const int *dadosAtaque, const int *dadosDefesa, int nAtaque, int nDefesa, const Regras *regras) {
+    int pares = minSemDesvio(nAtaque, nDefesa);
+    int vitoriasAtaque = contarVitoriasAtaque(dadosAtaque, dadosDefesa, pares, regras->empateAtacante);
+
+    ResultadoRolagem r;
+    r.perdasDefensor = vitoriasAtaque;
+    r.perdasAtacante = (pares - vitoriasAtaque) * regras->atacantePerde;
+    return r;
+}
+
+// combaterEspecializado():
+// Corpo comum dos kernels de combate. É sempre expandido em linha com parâmetros constantes
+// (MAX_A, MAX_D, EMPATE, PERDE), então o compilador elimina toda verificação de regra do laço interno.
+static inline __attribute__((always_inline)) ResultadoRolagem
+combaterEspecializado(GeradorAleatorio *rng, int nAtaque, int nDefesa, int *dadosAtaque, int *dadosDefesa,
+                      const int MAX_A, const int MAX_D, const int EMPATE, const int PERDE) {
+    nAtaque = minSemDesvio(nAtaque, MAX_A);
+    nDefesa = minSemDesvio(nDefesa, MAX_D);
+
+    // um único número de 64 bits fornece todos os dados (dígitos em base 6)
+    uint64_t x = proximoAleatorio(rng);
+    for (int i = 0; i < MAX_DADOS; ++i) {
+        unsigned __int128 m = (unsigned __int128)x * 6u;
+        dadosAtaque[i] = ((int)(m >> 64) + 1) & -(i < nAtaque);
+        x = (uint64_t)m;
+    }
+    for (int i = 0; i < MAX_DADOS; ++i) {
+        unsigned __int128 m = (unsigned __int128)x * 6u;
+        dadosDefesa[i] = ((int)(m >> 64) + 1) & -(i < nDefesa);
+        x = (uint64_t)m;
+    }
+
+    int pares = minSemDesvio(nAtaque, nDefesa);
+    int vitoriasAtaque = contarVitoriasAtaque(dadosAtaque, dadosDefesa, pares, EMPATE);
+
+    ResultadoRolagem r;
+    r.perdasDefensor = vitoriasAtaque;
+    r.perdasAtacante = (pares - vitoriasAtaque) * PERDE;
+    return r;
+}
+
+// Gera um kernel para cada combinação de (dados do atacante, dados do defensor, empate, perda do atacante).
+#define NOME_KERNEL(A, D, E, P) kernelCombate_##A##_##D##_##E##_##P
+#define DEFINIR_KERNEL(A, D, E, P)                                                                       \
+    static ResultadoRolagem NOME_KERNEL(A, D, E, P)(GeradorAleatorio *rng, int nAtaque, int nDefesa,     \
+                                                    int *dadosAtaque, int *dadosDefesa) {                \
+        return combaterEspecializado(rng, nAtaque, nDefesa, dadosAtaque, dadosDefesa, A, D, E, P);       \
+    }
+#define KERNELS_EMPATE_PERDA(A, D) \
+    DEFINIR_KERNEL(A, D, 0, 0) DEFINIR_KERNEL(A, D, 0, 1) DEFINIR_KERNEL(A, D, 1, 0) DEFINIR_KERNEL(A, D, 1, 1)
+#define KERNELS_DEFESA(A) KERNELS_EMPATE_PERDA(A, 1) KERNELS_EMPATE_PERDA(A, 2) KERNELS_EMPATE_PERDA(A, 3)
+KERNELS_DEFESA(1)
+KERNELS_DEFESA(2)
+KERNELS_DEFESA(3)
+
+// Tabela de kernels indexada por [dadosAtaque - 1][dadosDefesa - 1][empateAtacante][atacantePerde].
+#define LINHA_KERNELS(A, D) {{NOME_KERNEL(A, D, 0, 0), NOME_KERNEL(A, D, 0, 1)}, \
+                             {NOME_KERNEL(A, D, 1, 0), NOME_KERNEL(A, D, 1, 1)}}
+static const KernelCombate tabelaKernels[MAX_DADOS][MAX_DADOS][2][2] = {
+    {LINHA_KERNELS(1, 1), LINHA_KERNELS(1, 2), LINHA_KERNELS(1, 3)},
+    {LINHA_KERNELS(2, 1), LINHA_KERNELS(2, 2), LINHA_KERNELS(2, 3)},
+    {LINHA_KERNELS(3, 1), LINHA_KERNELS(3, 2), LINHA_KERNELS(3, 3)},
+};
+
+// prepararRegras():
+// Valida a combinação de regras e seleciona o kernel especializado correspondente.
+// Deve ser chamada uma vez por partida, antes de qualquer ataque. Retorna 0 se as regras forem inválidas.
+int prepararRegras(Regras *regras) {
+    if (regras->dadosAtaque < 1 || regras->dadosAtaque > MAX_DADOS) return 0;
+    if (regras->dadosDefesa < 1 || regras->dadosDefesa > MAX_DADOS) return 0;
+    if (regras->minimoConquista < 1) return 0;
+    regras->empateAtacante = regras->empateAtacante != 0;
+    regras->atacantePerde = regras->atacantePerde != 0;
+    regras->kernel = tabelaKernels[regras->dadosAtaque - 1][regras->dadosDefesa - 1]
+                                  [regras->empateAtacante][regras->atacantePerde];
+    return 1;
+}
+
+// semearGerador():
+// Inicializa o estado do gerador a partir de uma semente de 64 bits (expandida com splitmix64).
+void semearGerador(GeradorAleatorio *rng, uint64_t semente) {
+    for (int i = 0; i < 4; ++i) {
+        uint64_t z = (semente += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        rng->s[i] = z ^ (z >> 31);
+    }
+    rng->inverter = 0;
+}
+
+// sortearIntervalo():
+// Inteiro uniforme em [0, n) pela multiplicação de Lemire (parte alta de x * n): sem divisão e sem laço de
+// rejeição; o viés residual é menor que n / 2^64, irrelevante para os tamanhos usados no jogo.
+uint32_t sortearIntervalo(GeradorAleatorio *rng, uint32_t n) {
+    return (uint32_t)(((unsigned __int128)proximoAleatorio(rng) * n) >> 64);
+}
+
+// proximoAleatorio():
+// Retorna o próximo número de 64 bits da sequência (xoshiro256**), invertido se o gerador for antitético.
+uint64_t proximoAleatorio(GeradorAleatorio *rng) {
+    uint64_t *s = rng->s;
+    uint64_t resultado = s[1] * 5;
+    resultado = ((resultado << 7) | (resultado >> 57)) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+    return resultado ^ rng->inverter;
+}
+
+// montarCatalogo():
+// Monta o catálogo de missões da partida a partir do mapa e da quantidade de jogadores (dados, não código:
+// todas as entradas compilam para o mesmo predicado). Em ordem:
+// - destruir cada exército (a carta de destruir o jogador j fica no índice j);
+// - possuir 3/5 e 4/5 dos territórios;
+// - possuir dois continentes: todos os pares até 4 continentes, senão cada continente com o seguinte;
+// - ocupar 3/5 dos territórios com pelo menos TROPAS_OCUPACAO tropas.
+// Retorna 0 se faltar memória.
+int montarCatalogo(Jogo *jogo) {
+    int c = (int)jogo->totalContinentes;
+    int pares = c <= 4 ? c * (c - 1) / 2 : c;
+    jogo->catalogo = (DefinicaoMissao *)alocarArena(&jogo->memoria, (size_t)(jogo->totalJogadores + 3 + pares),
+                                                    sizeof(DefinicaoMissao));
+    if (jogo->catalogo == NULL) return 0;
+
+    int n = 0;
+    for (int j = 0; j < jogo->totalJogadores; ++j) jogo->catalogo[n++] = (DefinicaoMissao){MISSAO_DESTRUIR, j, 0, 0, 0};
+    jogo->catalogo[n++] = (DefinicaoMissao){MISSAO_TERRITORIOS, 0, (int)((jogo->total * 3 + 4) / 5), 0, 0};
+    jogo->catalogo[n++] = (DefinicaoMissao){MISSAO_TERRITORIOS, 0, (int)((jogo->total * 4 + 4) / 5), 0, 0};
+    if (c <= 4) {
+        for (int a = 0; a < c; ++a) {
+            for (int b = a + 1; b < c; ++b) jogo->catalogo[n++] = (DefinicaoMissao){MISSAO_CONTINENTES, 0, 0, a, b};
+        }
+    } else {
+        for (int a = 0; a < c; ++a) jogo->catalogo[n++] = (DefinicaoMissao){MISSAO_CONTINENTES, 0, 0, a, (a + 1) % c};
+    }
+    jogo->catalogo[n++] = (DefinicaoMissao){MISSAO_OCUPAR, 0, (int)((jogo->total * 3 + 4) / 5), 0, 0};
+    jogo->totalMissoes = n;
+    return 1;
+}
+
+// cartaInvalida():
+// Índice no catálogo da única carta que o jogador não pode receber (destruir o próprio exército), ou -1.
+// Pela ordem de montarCatalogo(), é a carta de índice igual ao ID do jogador.
+static int cartaInvalida(const Jogo *jogo, int jogador) {
+    return jogador < jogo->totalJogadores ? jogador : -1;
+}
+
+// sacarCarta():
+// Um passo do Fisher–Yates parcial: escolhe uniformemente uma carta entre baralho[proxima .. total) que não seja
+// a carta 'invalida', troca-a para a posição 'proxima' e a retorna. Em vez de sortear de novo quando sai a carta
+// inválida, o sorteio é feito em um intervalo uma posição menor e "pula" a posição dela: custo O(1) garantido.
+// 'posicao' é o inverso de 'baralho' (posição de cada carta) e é mantido nas trocas.
+static int sacarCarta(GeradorAleatorio *rng, int *baralho, int *posicao, int proxima, int total, int invalida) {
+    int restantes = total - proxima;
+    int posInvalida = (invalida >= 0 && posicao[invalida] >= proxima) ? posicao[invalida] : -1;
+    if (posInvalida >= 0 && restantes == 1) return invalida; // só sobrou a inválida: compilarMissao() usa a alternativa
+
+    int k;
+    if (posInvalida >= 0) {
+        k = proxima + (int)sortearIntervalo(rng, (uint32_t)(restantes - 1));
+        k += (k >= posInvalida);
+    } else {
+        k = proxima + (int)sortearIntervalo(rng, (uint32_t)restantes);
+    }
+    int carta = baralho[k];
+    baralho[k] = baralho[proxima];
+    posicao[baralho[k]] = k;
+    baralho[proxima] = carta;
+    posicao[carta] = proxima;
+    return carta;
+}
+
+// sortearMissao():
+// Sorteia uma missão do catálogo para um único jogador (com o gerador da partida), compila e guarda em
+// jogo->missoes. A carta de destruir o próprio exército é excluída do sorteio, sem novas tentativas.
+// Retorna o ID (índice no catálogo) da missão sorteada.
+int sortearMissao(Jogo *jogo, int jogador) {
+    int baralho[MAX_MISSOES], posicao[MAX_MISSOES];
+    for (int i = 0; i < jogo->totalMissoes; ++i) baralho[i] = posicao[i] = i;
+    int id = sacarCarta(&jogo->rng, baralho, posicao, 0, jogo->totalMissoes, cartaInvalida(jogo, jogador));
+    compilarMissao(jogo, id, jogador, &jogo->missoes[jogador]);
+    return id;
+}
+
+// distribuirMissoes():
+// Distribui missões diferentes para todos os jogadores com um único embaralhamento Fisher–Yates parcial:
+// o jogador j recebe a carta da posição j. Cada saque custa O(1), então o custo da distribuição é previsível
+// (O(jogadores)), mesmo com cartas inválidas. Se houver mais jogadores que missões, um novo baralho é aberto.
+void distribuirMissoes(Jogo *jogo) {
+    int baralho[MAX_MISSOES], posicao[MAX_MISSOES];
+    int proxima = jogo->totalMissoes;
+    for (int j = 0; j < jogo->totalJogadores; ++j) {
+        if (proxima == jogo->totalMissoes) {
+            for (int i = 0; i < jogo->totalMissoes; ++i) baralho[i] = posicao[i] = i;
+            proxima = 0;
+        }
+        int id = sacarCarta(&jogo->rng, baralho, posicao, proxima, jogo->totalMissoes, cartaInvalida(jogo, j));
+        proxima++;
+        compilarMissao(jogo, id, j, &jogo->missoes[j]);
+    }
+}
+
+// verificarVitoria():
+// Verifica se o jogador cumpriu os requisitos de sua missão atual avaliando o predicado compilado:
+// uma leitura de contador e uma de máscara, sem percorrer o mapa e sem depender do tipo da missão.
+// Retorna 1 (verdadeiro) se a missão foi cumprida, e 0 (falso) caso contrário.
+int verificarVitoria(const Jogo *jogo, int jogador) {
+    const MissaoCompilada *m = &jogo->missoes[jogador];
+    int valor = jogo->contadoresMissao[m->contador];
+    return (valor >= m->minimo) & (valor <= m->maximo) &
+           ((jogo->continentesJogador[m->jogador] & m->mascara) == m->mascara);
+}
+
+// missaoAlternativa():
+// Quantidade de territórios exigida quando a missão de destruir um exército não pode mais ser cumprida
+// (o alvo é o próprio jogador ou foi eliminado por outro): 3/5 do mapa, arredondado para cima.
+static int missaoAlternativa(const Jogo *jogo) {
+    return (int)((jogo->total * 3 + 4) / 5);
+}
+
+// compilarMissao():
+// Traduz uma entrada do catálogo para o predicado único de MissaoCompilada:
+// - destruir X:        territoriosJogador[X] == 0       (contador de X, mínimo 0, máximo 0)
+// - N territórios:     territoriosJogador[j] >= N
+// - continentes A e B: máscara com os bits de A e B
+// - ocupar N:          ocupadosJogador[j] >= N
+// idCatalogo -1 gera uma missão impossível (jogador sem missão).
+void compilarMissao(const Jogo *jogo, int idCatalogo, int jogador, MissaoCompilada *missao) {
+    missao->id = idCatalogo;
+    missao->jogador = jogador;
+    missao->contador = jogador;
+    missao->minimo = 0;
+    missao->maximo = INT32_MAX;
+    missao->mascara = 0;
+    if (idCatalogo < 0) {
+        missao->minimo = 1;
+        missao->maximo = 0;
+        return;
+    }
+
+    const DefinicaoMissao *d = &jogo->catalogo[idCatalogo];
+    switch (d->tipo) {
+        case MISSAO_DESTRUIR: {
+            int eliminadoPorOutro = jogo->territoriosJogador[d->alvo] == 0;
+            if (d->alvo == jogador || d->alvo >= jogo->totalJogadores || eliminadoPorOutro) {
+                missao->minimo = missaoAlternativa(jogo);
+            } else {
+                missao->contador = d->alvo;
+                missao->maximo = 0;
+            }
+            break;
+        }
+        case MISSAO_TERRITORIOS:
+            missao->minimo = d->quantidade;
+            break;
+        case MISSAO_CONTINENTES:
+            if ((size_t)d->continente1 >= jogo->totalContinentes || (size_t)d->continente2 >= jogo->totalContinentes) {
+                missao->minimo = 1; // continente inexistente neste mapa: missão impossível
+                missao->maximo = 0;
+                break;
+            }
+            missao->mascara = (UINT64_C(1) << d->continente1) | (UINT64_C(1) << d->continente2);
+            break;
+        case MISSAO_OCUPAR:
+            missao->contador = jogo->totalJogadores + jogador;
+            missao->minimo = d->quantidade;
+            break;
+    }
+}
+
+// descreverMissao():
+// Gera o texto da missão (inclusive quando foi trocada pela alternativa).
+void descreverMissao(const Jogo *jogo, const MissaoCompilada *missao, char *descricao, size_t descSize) {
+    if (missao->id < 0) {
+        snprintf(descricao, descSize, "Nenhuma missão");
+        return;
+    }
+    const DefinicaoMissao *d = &jogo->catalogo[missao->id];
+    if (d->tipo == MISSAO_DESTRUIR && missao->contador != d->alvo) {
+        snprintf(descricao, descSize, "Conquistar %d territórios (alvo original indisponível)", missao->minimo);
+        return;
+    }
+    switch (d->tipo) {
+        case MISSAO_DESTRUIR:
+            snprintf(descricao, descSize, "Destruir o exército %s", jogo->nomesJogadores[d->alvo]);
+            break;
+        case MISSAO_TERRITORIOS:
+            snprintf(descricao, descSize, "Conquistar %d territórios (ser dono de pelo menos %d territórios)", d->quantidade, d->quantidade);
+            break;
+        case MISSAO_CONTINENTES:
+            snprintf(descricao, descSize, "Conquistar os continentes %s e %s",
+                     jogo->continentes[d->continente1].nome, jogo->continentes[d->continente2].nome);
+            break;
+        case MISSAO_OCUPAR:
+            snprintf(descricao, descSize, "Ocupar %d territórios com pelo menos %d tropas cada", d->quantidade, TROPAS_OCUPACAO);
+            break;
+    }
+}
+
+// limparBufferEntrada():
+// Função utilitária para limpar o buffer de entrada do teclado (stdin), descartando o resto da linha atual.
+void limparBufferEntrada(void) {
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF) { /* descarta */ }
+}
+
+// lerLinha():
+// Lê uma linha do terminal sem o '\n', descartando o que não couber no buffer. Retorna 0 no fim da entrada.
+// Toda leitura interativa passa por aqui, então um replay por pipe vazio ou truncado sempre termina.
+int lerLinha(char *linha, size_t tamanho) {
+    if (fgets(linha, (int)tamanho, stdin) == NULL) return 0;
+    char *fim = linha + strcspn(linha, "\r\n");
+    if (*fim == '\0') limparBufferEntrada(); // linha maior que o buffer
+    *fim = '\0';
+    return 1;
+}
+
+// converterInteiro():
+// Converte o texto em inteiro se ele for só um número (espaços ao redor são aceitos). Retorna 1 se converteu.
+int converterInteiro(const char *texto, int *valor) {
+    char *resto;
+    errno = 0;
+    long numero = strtol(texto, &resto, 10);
+    if (resto == texto || errno == ERANGE || numero < INT_MIN || numero > INT_MAX) return 0;
+    resto += strspn(resto, " \t");
+    if (*resto != '\0') return 0;
+    *valor = (int)numero;
+    return 1;
+}
+
+// converterInteiroLongo():
+// Como converterInteiro(), para a faixa de long long.
+int converterInteiroLongo(const char *texto, long long *valor) {
+    char *resto;
+    errno = 0;
+    long long numero = strtoll(texto, &resto, 10);
+    if (resto == texto || errno == ERANGE) return 0;
+    resto += strspn(resto, " \t");
+    if (*resto != '\0') return 0;
+    *valor = numero;
+    return 1;
+}
+
+// converterNatural():
+// Como converterInteiro(), para números sem sinal de 64 bits (sementes); recusa o sinal de menos,
+// que strtoull() aceitaria dando a volta no número.
+int converterNatural(const char *texto, uint64_t *valor) {
+    char *resto;
+    texto += strspn(texto, " \t");
+    if (*texto == '-') return 0;
+    errno = 0;
+    unsigned long long numero = strtoull(texto, &resto, 10);
+    if (resto == texto || errno == ERANGE) return 0;
+    resto += strspn(resto, " \t");
+    if (*resto != '\0') return 0;
+    *valor = (uint64_t)numero;
+    return 1;
+}
+
+// converterReal():
+// Como converterInteiro(), para um número real finito.
+int converterReal(const char *texto, double *valor) {
+    char *resto;
+    errno = 0;
+    double numero = strtod(texto, &resto);
+    if (resto == texto || errno == ERANGE || !isfinite(numero)) return 0;
+    resto += strspn(resto, " \t");
+    if (*resto != '\0') return 0;
+    *valor = numero;
+    return 1;
+}
+
+// lerInteiro():
+// Lê uma linha do terminal com um número. Retorna 1 se leu, 0 se a linha não era um número
+// ou FIM_ENTRADA se a entrada acabou.
+int lerInteiro(int *valor) {
+    char linha[TAM_LINHA];
+    if (!lerLinha(linha, sizeof(linha))) return FIM_ENTRADA;
+    return converterInteiro(linha, valor);
+}
+
+// lerTerritorio():
+// Lê uma linha do terminal com um território, por índice (1 a total) ou por nome. Retorna o índice a partir
+// de 0, -1 se a entrada não corresponder a nenhum território ou FIM_ENTRADA se a entrada acabou.
+int lerTerritorio(const Jogo *jogo) {
+    char linha[TAM_LINHA];
+    char *tokens[1];
+    if (!lerLinha(linha, sizeof(linha))) return FIM_ENTRADA;
+    // a linha inteira é o nome (sem aspas, "Mata Atlantica" também funciona)
+    char *fim = linha + strlen(linha);
+    while (fim > linha && fim[-1] == ' ') *--fim = '\0';
+    char *inicio = linha + strspn(linha, " \t");
+    char *resto;
+    long numero = strtol(inicio, &resto, 10);
+    if (resto != inicio && *resto == '\0') return numero >= 1 && numero <= (long)jogo->total ? (int)(numero - 1) : -1;
+    if (*inicio == '"' && separarTokens(inicio, tokens, 1) == 1) return buscarTerritorio(jogo, tokens[0]);
+    return buscarTerritorio(jogo, inicio);
+}
+
+// separarTokens():
+// Divide a linha (no próprio buffer) em até 'maxTokens' palavras separadas por espaços; um trecho entre aspas
+// conta como uma palavra só. Retorna quantas palavras foram encontradas.
+int separarTokens(char *linha, char **tokens, int maxTokens) {
+    int n = 0;
+    char *p = linha;
+    while (n < maxTokens) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        if (*p == '\0') break;
+        if (*p == '"') {
+            tokens[n++] = ++p;
+            while (*p != '\0' && *p != '"') p++;
+        } else {
+            tokens[n++] = p;
+            while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+        }
+        if (*p == '\0') break;
+        *p++ = '\0';
+    }
+    return n;
+}
+
+// lerOpcaoRegras():
+// Interpreta a opção argv[*i] se ela ajustar as regras de combate ou a execução paralela, avançando *i sobre
+// o valor consumido. Retorna 1 se a opção foi lida, 0 se não é uma opção de regras e -1 (com mensagem) se for inválida.
+int lerOpcaoRegras(int argc, char *argv[], int *i, Regras *regras) {
+    if (*i + 1 >= argc) return 0;
+    const char *opcao = argv[*i];
+    if (strcmp(opcao, "--regras") == 0) {
+        const Regras *base = buscarRegras(argv[++*i]);
+        if (base == NULL) {
+            fprintf(stderr, "Erro: variante de regras desconhecida '%s' (use original, classica ou risk).\n", argv[*i]);
+            return -1;
+        }
+        *regras = *base;
+    } else if (strcmp(opcao, "--dados-ataque") == 0 || strcmp(opcao, "--dados-defesa") == 0) {
+        int *dados = strcmp(opcao, "--dados-ataque") == 0 ? &regras->dadosAtaque : &regras->dadosDefesa;
+        if (!converterInteiro(argv[++*i], dados) || *dados < 1 || *dados > MAX_DADOS) {
+            fprintf(stderr, "Erro: %s espera um número de dados de 1 a %d, não '%s'.\n", opcao, MAX_DADOS, argv[*i]);
+            return -1;
+        }
+    } else if (strcmp(opcao, "--empate") == 0) {
+        const char *vencedor = argv[++*i];
+        if (strcmp(vencedor, "atacante") != 0 && strcmp(vencedor, "defensor") != 0) {
+            fprintf(stderr, "Erro: valor de --empate desconhecido '%s' (use atacante ou defensor).\n", vencedor);
+            return -1;
+        }
+        regras->empateAtacante = strcmp(vencedor, "atacante") == 0;
+    } else if (strcmp(opcao, "--minimo-conquista") == 0) {
+        if (!converterInteiro(argv[++*i], &regras->minimoConquista) || regras->minimoConquista < 1) {
+            fprintf(stderr, "Erro: --minimo-conquista espera um número de tropas maior que zero, não '%s'.\n", argv[*i]);
+            return -1;
+        }
+    } else if (strcmp(opcao, "--threads") == 0) {
+        int threads;
+        if (!converterInteiro(argv[++*i], &threads) || threads < 0) {
+            fprintf(stderr, "Erro: --threads espera um número de threads (0 = núcleos disponíveis), não '%s'.\n",
+                    argv[*i]);
+            return -1;
+        }
+        definirThreads(threads);
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+// lerOpcaoMapa():
+// Interpreta --territorios N e --jogadores N (mapa gerado), avançando *i sobre o valor consumido. *jogadores fica
+// como está (0 = não informado) até a opção aparecer. Retorna 1 se a opção foi lida, 0 se não é uma opção de mapa
+// e -1 (com mensagem) se o valor for inválido.
+int lerOpcaoMapa(int argc, char *argv[], int *i, size_t *territorios, int *jogadores) {
+    if (*i + 1 >= argc) return 0;
+    const char *opcao = argv[*i];
+    int valor;
+    if (strcmp(opcao, "--territorios") == 0) {
+        if (!converterInteiro(argv[++*i], &valor) || valor < 0) {
+            fprintf(stderr, "Erro: --territorios espera um número de territórios (0 = mapa padrão), não '%s'.\n",
+                    argv[*i]);
+            return -1;
+        }
+        *territorios = (size_t)valor;
+    } else if (strcmp(opcao, "--jogadores") == 0) {
+        if (!converterInteiro(argv[++*i], &valor) || valor < 2 || valor > MAX_JOGADORES) {
+            fprintf(stderr, "Erro: --jogadores espera um número de 2 a %d, não '%s'.\n", MAX_JOGADORES, argv[*i]);
+            return -1;
+        }
+        *jogadores = valor;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+// conferirOpcaoMapa():
+// Depois das opções: recusa --jogadores quando o mapa é o padrão (os exércitos dele são fixos e a opção seria
+// ignorada) e, sem --jogadores, usa TOTAL_JOGADORES. Retorna 0 (com mensagem) se a combinação for inválida.
+int conferirOpcaoMapa(size_t territorios, int *jogadores) {
+    if (territorios == 0 && *jogadores != 0) {
+        fprintf(stderr, "Erro: --jogadores só vale para mapas gerados (use também --territorios N).\n");
+        return 0;
+    }
+    if (*jogadores == 0) *jogadores = TOTAL_JOGADORES;
+    return 1;
+}
+
+// buscarJogador():
+// Retorna o ID do jogador com o nome dado (ou -1 caso não encontre).
+int buscarJogador(const Jogo *jogo, const char *nome) {
+    for (int j = 0; j < jogo->totalJogadores; ++j) {
+        if (strcmp(jogo->nomesJogadores[j], nome) == 0) return j;
+    }
+    return -1;
+}
+
+// codigoCorJogador():
+// Gera a sequência ANSI da cor do jogador a partir do ID. Os cinco exércitos clássicos mantêm suas cores; os demais
+// espalham o matiz pela razão áurea (IDs vizinhos ficam com cores bem diferentes) e alternam saturação e brilho.
+// Usa cor de 24 bits quando o terminal anuncia suporte (COLORTERM=truecolor ou 24bit) e, caso contrário,
+// a cor mais próxima do cubo 6x6x6 da paleta de 256 cores. Com NO_COLOR definido, gera uma string vazia.
+void codigoCorJogador(int jogador, char *codigo, size_t tamanho) {
+    static _Atomic int modo = -1; // 0 = sem cor, 1 = 256 cores, 2 = 24 bits (atômico: partidas paralelas)
+    if (modo < 0) {
+        const char *colorterm = getenv("COLORTERM");
+        if (getenv("NO_COLOR") != NULL) modo = 0;
+        else if (colorterm != NULL && (strcmp(colorterm, "truecolor") == 0 || strcmp(colorterm, "24bit") == 0)) modo = 2;
+        else modo = 1;
+    }
+    if (modo == 0) {
+        codigo[0] = '\0';
+        return;
+    }
+
+    int rgb[3];
+    if (jogador < TOTAL_JOGADORES) {
+        for (int k = 0; k < 3; ++k) rgb[k] = coresClassicas[jogador][k];
+    } else {
+        // HSV -> RGB com matiz = frac(jogador * 0.618...) em sextos do círculo
+        double h = (double)jogador * 0.6180339887498949;
+        h = (h - (double)(long)h) * 6.0;
+        double s = (jogador % 2) ? 0.55 : 0.9;
+        double v = (jogador % 3 == 2) ? 0.7 : 1.0;
+        int setor = (int)h;
+        double f = h - setor;
+        double p = v * (1.0 - s), q = v * (1.0 - s * f), t = v * (1.0 - s * (1.0 - f));
+        double r, g, b;
+        switch (setor) {
+            case 0: r = v; g = t; b = p; break;
+            case 1: r = q; g = v; b = p; break;
+            case 2: r = p; g = v; b = t; break;
+            case 3: r = p; g = q; b = v; break;
+            case 4: r = t; g = p; b = v; break;
+            default: r = v; g = p; b = q; break;
+        }
+        rgb[0] = (int)(r * 255.0 + 0.5);
+        rgb[1] = (int)(g * 255.0 + 0.5);
+        rgb[2] = (int)(b * 255.0 + 0.5);
+    }
+
+    if (modo == 2) {
+        snprintf(codigo, tamanho, "\033[38;2;%d;%d;%dm", rgb[0], rgb[1], rgb[2]);
+        return;
+    }
+    // níveis do cubo: 0, 95, 135, 175, 215, 255
+    int nivel[3];
+    for (int k = 0; k < 3; ++k) nivel[k] = rgb[k] < 48 ? 0 : rgb[k] < 115 ? 1 : (rgb[k] - 35) / 40;
+    snprintf(codigo, tamanho, "\033[38;5;%dm", 16 + 36 * nivel[0] + 6 * nivel[1] + nivel[2]);
+}